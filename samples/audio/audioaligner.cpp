@@ -0,0 +1,85 @@
+#include <cstdint>
+
+#include "twitchsdk.h"
+#include "audioaligner.h"
+
+namespace
+{
+	const uint kSampleRate = 44100;
+	const uint kNumChannels = 2;
+	const uint kSilenceFrames = kSampleRate / 10;		// Gaps are filled 100 ms at a time
+	const uint64_t kMaxGapFrames = kSampleRate * 10;	// Larger jumps in either direction are timestamp errors, not hitches
+}
+
+//--------------------------------------------------------------------------
+AudioAligner::AudioAligner(uint toleranceMs)
+: mSilence(kSilenceFrames * kNumChannels, 0)
+, mToleranceFrames(static_cast<uint64_t>(toleranceMs) * kSampleRate / 1000)
+{
+	Reset();
+}
+
+//--------------------------------------------------------------------------
+void AudioAligner::Reset()
+{
+	mSubmittedFrames = 0;
+	mInsertedFrames = 0;
+	mTrimmedFrames = 0;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode AudioAligner::SubmitAudioSamples(const int16_t* samplesBuffer, uint numSamples, uint64_t captureTimeMs)
+{
+	if (samplesBuffer == nullptr || numSamples % kNumChannels != 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	const uint64_t expectedFrame = captureTimeMs * kSampleRate / 1000;
+	uint64_t numFrames = numSamples / kNumChannels;
+
+	if (expectedFrame > mSubmittedFrames + mToleranceFrames && expectedFrame - mSubmittedFrames <= kMaxGapFrames)
+	{
+		// Samples went missing, fill the gap with silence
+		uint64_t gap = expectedFrame - mSubmittedFrames;
+		while (gap > 0)
+		{
+			const uint frames = static_cast<uint>(gap < kSilenceFrames ? gap : kSilenceFrames);
+			TTV_ErrorCode ret = TTV_SubmitAudioSamples(mSilence.data(), frames * kNumChannels);
+			if (TTV_FAILED(ret))
+			{
+				return ret;
+			}
+
+			gap -= frames;
+			mSubmittedFrames += frames;
+			mInsertedFrames += frames;
+		}
+	}
+	else if (expectedFrame + mToleranceFrames < mSubmittedFrames && mSubmittedFrames - expectedFrame <= kMaxGapFrames)
+	{
+		// The start of the buffer overlaps audio that was already submitted
+		uint64_t overlap = mSubmittedFrames - expectedFrame;
+		if (overlap > numFrames)
+		{
+			overlap = numFrames;
+		}
+
+		samplesBuffer += overlap * kNumChannels;
+		numFrames -= overlap;
+		mTrimmedFrames += overlap;
+	}
+
+	if (numFrames == 0)
+	{
+		return TTV_EC_SUCCESS;
+	}
+
+	TTV_ErrorCode ret = TTV_SubmitAudioSamples(samplesBuffer, static_cast<uint>(numFrames * kNumChannels));
+	if (TTV_SUCCEEDED(ret))
+	{
+		mSubmittedFrames += numFrames;
+	}
+
+	return ret;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+#include "twitchcore/types/errortypes.h"
+
+#include <vector>
+
+/**
+* AudioAligner - Submits passthrough audio that carries a capture timestamp.
+*
+* TTV_SubmitAudioSamples assumes the samples are contiguous from the first video frame on, so a hitch
+* in the game's audio thread that loses or delays samples permanently shifts audio against video.
+* The aligner keeps track of where in the stream the submitted audio ends. When a buffer arrives
+* with a timestamp later than that it submits silence to fill the gap, and when it arrives earlier
+* it trims the part that overlaps, so the stream realigns instead of drifting. Timestamps more than
+* 10 seconds off in either direction are treated as bogus and the samples are submitted unchanged.
+*
+* Samples must be in the format TTV_SubmitAudioSamples takes (2-channel 16-bit PCM @ 44100 Hz,
+* see AudioConverter). Timestamps are in stream time (see TTV_GetStreamTime).
+*/
+class AudioAligner
+{
+public:
+	/**
+	* @param[in] toleranceMs - Deviations up to this many milliseconds are treated as jitter and left alone
+	*/
+	explicit AudioAligner(uint toleranceMs = 20);
+
+	/**
+	* Reset - Start over at stream time 0 (call this when a broadcast starts)
+	*/
+	void Reset();
+
+	/**
+	* SubmitAudioSamples - Align the samples to their timestamp and pass them to TTV_SubmitAudioSamples.
+	* @param[in] samplesBuffer - The audio samples
+	* @param[in] numSamples - Number of audio samples in the buffer (total NOT per channel)
+	* @param[in] captureTimeMs - The stream time in milliseconds at which the first sample was captured
+	* @return - TTV_EC_SUCCESS if function succeeds; error code otherwise
+	*/
+	TTV_ErrorCode SubmitAudioSamples(const int16_t* samplesBuffer, uint numSamples, uint64_t captureTimeMs);
+
+	/**
+	* GetInsertedFrames - Total number of silent sample frames inserted to fill gaps
+	*/
+	uint64_t GetInsertedFrames() const { return mInsertedFrames; }
+
+	/**
+	* GetTrimmedFrames - Total number of sample frames dropped because they overlapped audio already submitted
+	*/
+	uint64_t GetTrimmedFrames() const { return mTrimmedFrames; }
+
+private:
+	std::vector<int16_t> mSilence;
+	uint64_t mSubmittedFrames;
+	uint64_t mInsertedFrames;
+	uint64_t mTrimmedFrames;
+	uint64_t mToleranceFrames;
+};
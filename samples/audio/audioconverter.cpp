@@ -0,0 +1,520 @@
+#include <cmath>
+#include <cstdint>
+
+#include "twitchsdk.h"
+#include "audiosimd.h"
+#include "audioconverter.h"
+
+namespace
+{
+	const uint kOutputSampleRate = 44100;			// The rate TTV_SubmitAudioSamples requires
+	const uint kMinSampleRate = 8000;
+	const uint kMaxSampleRate = 192000;
+	const uint kMaxChannels = 8;
+
+	// The filter is designed relative to the lower of the input and output rate so the kernel has the
+	// same length in output frames when downsampling. Kaiser window for about 80 dB of stopband
+	// attenuation, flat to 19 kHz and fully attenuated at 22050 Hz at the 44100 Hz output rate.
+	const double kPassband = 19000.0 / 44100.0;	// Fraction of the lower rate that is kept
+	const double kStopband = 0.5;					// Fraction of the lower rate where the stopband starts
+	const double kStopbandAttenuation = 80.0;		// dB
+	const uint kPhaseBits = 8;
+	const uint kNumPhases = 1 << kPhaseBits;		// Filter phases between two input frames
+	const uint kWeightBits = 32 - kPhaseBits;
+	const uint64_t kFixedOne = 1ull << 32;
+	const double kMaxRateAdjustment = 0.01;			// Clocks that are off by more than 1% are not drifting but misconfigured
+
+	const float kMinusThreeDb = 0.7071068f;
+	const double kPi = 3.14159265358979323846;
+}
+
+//--------------------------------------------------------------------------
+static inline int16_t SaturateToInt16(float sample)
+{
+	if (sample <= -32768.0f)
+	{
+		return INT16_MIN;
+	}
+	if (sample >= 32767.0f)
+	{
+		return INT16_MAX;
+	}
+
+	return static_cast<int16_t>(sample < 0.0f ? sample - 0.5f : sample + 0.5f);
+}
+
+//--------------------------------------------------------------------------
+static inline void InterpolateTaps(const float* a, const float* b, float weight, float* taps, uint numTaps)
+{
+	uint k = 0;
+
+#if AUDIO_SSE2
+	const __m128 w = _mm_set1_ps(weight);
+	for (; k + 4 <= numTaps; k += 4)
+	{
+		__m128 va = _mm_loadu_ps(a + k);
+		_mm_storeu_ps(taps + k, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + k), va), w)));
+	}
+#elif AUDIO_NEON
+	for (; k + 4 <= numTaps; k += 4)
+	{
+		float32x4_t va = vld1q_f32(a + k);
+		vst1q_f32(taps + k, vmlaq_n_f32(va, vsubq_f32(vld1q_f32(b + k), va), weight));
+	}
+#endif
+
+	for (; k < numTaps; ++k)
+	{
+		taps[k] = a[k] + (b[k] - a[k]) * weight;
+	}
+}
+
+//--------------------------------------------------------------------------
+static inline float DotProduct(const float* taps, const float* samples, uint numTaps)
+{
+	uint k = 0;
+	float sum = 0.0f;
+
+#if AUDIO_SSE2
+	__m128 acc = _mm_setzero_ps();
+	for (; k + 4 <= numTaps; k += 4)
+	{
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(samples + k)));
+	}
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+	sum = _mm_cvtss_f32(acc);
+#elif AUDIO_NEON
+	float32x4_t acc = vdupq_n_f32(0.0f);
+	for (; k + 4 <= numTaps; k += 4)
+	{
+		acc = vmlaq_f32(acc, vld1q_f32(taps + k), vld1q_f32(samples + k));
+	}
+	float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+	sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+
+	for (; k < numTaps; ++k)
+	{
+		sum += taps[k] * samples[k];
+	}
+
+	return sum;
+}
+
+#if AUDIO_SSE2
+//--------------------------------------------------------------------------
+// One channel of 4 consecutive interleaved frames
+static inline __m128 LoadChannel(const float* in, uint stride)
+{
+	return _mm_setr_ps(in[0], in[stride], in[stride * 2], in[stride * 3]);
+}
+
+//--------------------------------------------------------------------------
+static inline __m128 LoadChannel(const int16_t* in, uint stride)
+{
+	return _mm_cvtepi32_ps(_mm_setr_epi32(in[0], in[stride], in[stride * 2], in[stride * 3]));
+}
+#elif AUDIO_NEON
+//--------------------------------------------------------------------------
+// One channel of 4 consecutive interleaved frames
+static inline float32x4_t LoadChannel(const float* in, uint stride)
+{
+	float32x4_t v = vdupq_n_f32(in[0]);
+	v = vld1q_lane_f32(in + stride, v, 1);
+	v = vld1q_lane_f32(in + stride * 2, v, 2);
+	return vld1q_lane_f32(in + stride * 3, v, 3);
+}
+
+//--------------------------------------------------------------------------
+static inline float32x4_t LoadChannel(const int16_t* in, uint stride)
+{
+	int16x4_t v = vdup_n_s16(in[0]);
+	v = vld1_lane_s16(in + stride, v, 1);
+	v = vld1_lane_s16(in + stride * 2, v, 2);
+	v = vld1_lane_s16(in + stride * 3, v, 3);
+	return vcvtq_f32_s32(vmovl_s16(v));
+}
+#endif
+
+//--------------------------------------------------------------------------
+// Multiplies interleaved frames with the downmix matrix (left/right gain pairs per channel), 4 frames at a time
+template <typename SampleType>
+static void DownmixFrames(const SampleType* in, uint numFrames, uint numChannels, const float* gains, float scale, float* left, float* right)
+{
+	uint i = 0;
+
+#if AUDIO_SSE2
+	const __m128 s = _mm_set1_ps(scale);
+	for (; i + 4 <= numFrames; i += 4)
+	{
+		const SampleType* frames = in + static_cast<size_t>(i) * numChannels;
+		__m128 l = _mm_setzero_ps();
+		__m128 r = _mm_setzero_ps();
+		for (uint c = 0; c < numChannels; ++c)
+		{
+			__m128 v = LoadChannel(frames + c, numChannels);
+			l = _mm_add_ps(l, _mm_mul_ps(v, _mm_set1_ps(gains[c * 2])));
+			r = _mm_add_ps(r, _mm_mul_ps(v, _mm_set1_ps(gains[c * 2 + 1])));
+		}
+		_mm_storeu_ps(left + i, _mm_mul_ps(l, s));
+		_mm_storeu_ps(right + i, _mm_mul_ps(r, s));
+	}
+#elif AUDIO_NEON
+	for (; i + 4 <= numFrames; i += 4)
+	{
+		const SampleType* frames = in + static_cast<size_t>(i) * numChannels;
+		float32x4_t l = vdupq_n_f32(0.0f);
+		float32x4_t r = vdupq_n_f32(0.0f);
+		for (uint c = 0; c < numChannels; ++c)
+		{
+			float32x4_t v = LoadChannel(frames + c, numChannels);
+			l = vmlaq_n_f32(l, v, gains[c * 2]);
+			r = vmlaq_n_f32(r, v, gains[c * 2 + 1]);
+		}
+		vst1q_f32(left + i, vmulq_n_f32(l, scale));
+		vst1q_f32(right + i, vmulq_n_f32(r, scale));
+	}
+#endif
+
+	for (; i < numFrames; ++i)
+	{
+		const SampleType* frame = in + static_cast<size_t>(i) * numChannels;
+		float l = 0.0f;
+		float r = 0.0f;
+		for (uint c = 0; c < numChannels; ++c)
+		{
+			const float sample = static_cast<float>(frame[c]);
+			l += sample * gains[c * 2];
+			r += sample * gains[c * 2 + 1];
+		}
+		left[i] = l * scale;
+		right[i] = r * scale;
+	}
+}
+
+//--------------------------------------------------------------------------
+static double BesselI0(double x)
+{
+	// Power series, converges quickly for the arguments a Kaiser window needs
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 50 && term > sum * 1e-12; ++k)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+
+//--------------------------------------------------------------------------
+AudioConverter::AudioConverter()
+: mPosition(0)
+, mStep(0)
+, mNumTaps(0)
+, mHalfTaps(0)
+, mFormat(SF_S16)
+, mNumChannels(0)
+, mSampleRate(0)
+{
+
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode AudioConverter::Init(SampleFormat format, uint numChannels, uint sampleRate)
+{
+	if ((format != SF_S16 && format != SF_FLOAT) ||
+		numChannels == 0 || numChannels > kMaxChannels ||
+		sampleRate < kMinSampleRate || sampleRate > kMaxSampleRate)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	mFormat = format;
+	mNumChannels = numChannels;
+	mSampleRate = sampleRate;
+
+	// Downmix matrix, pairs of left/right gains per input channel
+	mChannelGains.assign(numChannels * 2, 0.0f);
+	if (numChannels == 1)
+	{
+		mChannelGains[0] = 1.0f;
+		mChannelGains[1] = 1.0f;
+	}
+	else if (numChannels == 4)
+	{
+		mChannelGains[0] = 1.0f;
+		mChannelGains[3] = 1.0f;
+		mChannelGains[4] = kMinusThreeDb;
+		mChannelGains[7] = kMinusThreeDb;
+	}
+	else
+	{
+		mChannelGains[0] = 1.0f;
+		mChannelGains[3] = 1.0f;
+		for (uint c = 2; c < numChannels; ++c)
+		{
+			if (c == 2)
+			{
+				// Center goes to both sides
+				mChannelGains[4] = kMinusThreeDb;
+				mChannelGains[5] = kMinusThreeDb;
+			}
+			else if (c > 3)
+			{
+				// The LFE channel (3) is dropped, surrounds go to their side
+				mChannelGains[c * 2 + (c & 1)] = kMinusThreeDb;
+			}
+		}
+	}
+
+	// Keep the downmix from clipping when all channels are loud at once
+	if (numChannels > 2)
+	{
+		float sumLeft = 0.0f;
+		float sumRight = 0.0f;
+		for (uint c = 0; c < numChannels; ++c)
+		{
+			sumLeft += mChannelGains[c * 2];
+			sumRight += mChannelGains[c * 2 + 1];
+		}
+
+		const float normalize = 1.0f / (sumLeft > sumRight ? sumLeft : sumRight);
+		for (size_t i = 0; i < mChannelGains.size(); ++i)
+		{
+			mChannelGains[i] *= normalize;
+		}
+	}
+
+	// Kaiser windowed sinc filter. The transition band and the attenuation set the length, which
+	// grows with the input rate when downsampling so high input rates don't alias
+	const double lowerRate = static_cast<double>(sampleRate < kOutputSampleRate ? sampleRate : kOutputSampleRate);
+	const double inputScale = lowerRate / sampleRate;
+	const double cutoff = 0.5 * (kPassband + kStopband) * inputScale;					// Cycles per input frame
+	const double transition = 2.0 * kPi * (kStopband - kPassband) * inputScale;			// Radians per input frame
+	const double beta = 0.1102 * (kStopbandAttenuation - 8.7);
+	const uint minTaps = static_cast<uint>(ceil((kStopbandAttenuation - 8.0) / (2.285 * transition))) + 1;
+
+	// A multiple of 8 keeps the SIMD loops free of tails and the two halves equal
+	mNumTaps = (minTaps + 7) & ~7u;
+	mHalfTaps = mNumTaps / 2;
+
+	// One row per phase plus one extra row to interpolate towards
+	const double windowScale = 1.0 / BesselI0(beta);
+	mCoefficients.resize((kNumPhases + 1) * mNumTaps);
+	for (uint p = 0; p <= kNumPhases; ++p)
+	{
+		float* row = &mCoefficients[p * mNumTaps];
+		double sum = 0.0;
+		for (uint k = 0; k < mNumTaps; ++k)
+		{
+			const double distance = static_cast<double>(k) - (mHalfTaps - 1) - static_cast<double>(p) / kNumPhases;
+			const double x = 2.0 * cutoff * distance;
+			const double sinc = x == 0.0 ? 1.0 : sin(kPi * x) / (kPi * x);
+			const double edge = distance / mHalfTaps;
+			const double window = edge * edge < 1.0 ? BesselI0(beta * sqrt(1.0 - edge * edge)) * windowScale : 0.0;
+			row[k] = static_cast<float>(sinc * window);
+			sum += row[k];
+		}
+
+		// Unity gain at DC for every phase
+		for (uint k = 0; k < mNumTaps; ++k)
+		{
+			row[k] = static_cast<float>(row[k] / sum);
+		}
+	}
+	mTaps.resize(mNumTaps);
+
+	SetRateAdjustment(1.0);
+
+	// Prime the history so the first output frame lines up with the first input frame
+	mLeft.assign(mHalfTaps - 1, 0.0f);
+	mRight.assign(mHalfTaps - 1, 0.0f);
+	mPosition = static_cast<uint64_t>(mHalfTaps - 1) << 32;
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode AudioConverter::SetRateAdjustment(double ratio)
+{
+	if (mNumChannels == 0)
+	{
+		return TTV_EC_NOT_INITIALIZED;
+	}
+	if (ratio < 1.0 - kMaxRateAdjustment || ratio > 1.0 + kMaxRateAdjustment)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	mStep = static_cast<uint64_t>(static_cast<double>(mSampleRate) * ratio / kOutputSampleRate * kFixedOne + 0.5);
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode AudioConverter::Convert(const void* samples, uint numSamples, std::vector<int16_t>& output)
+{
+	if (mNumChannels == 0)
+	{
+		return TTV_EC_NOT_INITIALIZED;
+	}
+	if (samples == nullptr || numSamples % mNumChannels != 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	Downmix(samples, numSamples / mNumChannels);
+	Resample(output);
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode AudioConverter::SubmitAudioSamples(const void* samples, uint numSamples)
+{
+	mOutput.clear();
+
+	TTV_ErrorCode ret = Convert(samples, numSamples, mOutput);
+	if (TTV_FAILED(ret) || mOutput.empty())
+	{
+		return ret;
+	}
+
+	return TTV_SubmitAudioSamples(mOutput.data(), static_cast<uint>(mOutput.size()));
+}
+
+//--------------------------------------------------------------------------
+void AudioConverter::Downmix(const void* samples, uint numFrames)
+{
+	if (numFrames == 0)
+	{
+		return;
+	}
+
+	const size_t base = mLeft.size();
+	mLeft.resize(base + numFrames);
+	mRight.resize(base + numFrames);
+
+	float* left = &mLeft[base];
+	float* right = &mRight[base];
+	const float scale = mFormat == SF_FLOAT ? 32768.0f : 1.0f;
+	uint i = 0;
+
+	if (mNumChannels == 2)
+	{
+		// Plain deinterleave for the common stereo case
+		if (mFormat == SF_FLOAT)
+		{
+			const float* in = static_cast<const float*>(samples);
+#if AUDIO_SSE2
+			const __m128 s = _mm_set1_ps(scale);
+			for (; i + 4 <= numFrames; i += 4)
+			{
+				__m128 a = _mm_loadu_ps(in + i * 2);
+				__m128 b = _mm_loadu_ps(in + i * 2 + 4);
+				_mm_storeu_ps(left + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), s));
+				_mm_storeu_ps(right + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), s));
+			}
+#elif AUDIO_NEON
+			for (; i + 4 <= numFrames; i += 4)
+			{
+				float32x4x2_t lr = vld2q_f32(in + i * 2);
+				vst1q_f32(left + i, vmulq_n_f32(lr.val[0], scale));
+				vst1q_f32(right + i, vmulq_n_f32(lr.val[1], scale));
+			}
+#endif
+			for (; i < numFrames; ++i)
+			{
+				left[i] = in[i * 2] * scale;
+				right[i] = in[i * 2 + 1] * scale;
+			}
+		}
+		else
+		{
+			const int16_t* in = static_cast<const int16_t*>(samples);
+#if AUDIO_SSE2
+			for (; i + 4 <= numFrames; i += 4)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+				__m128 a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+				__m128 b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+				_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+#elif AUDIO_NEON
+			for (; i + 4 <= numFrames; i += 4)
+			{
+				int16x4x2_t lr = vld2_s16(in + i * 2);
+				vst1q_f32(left + i, vcvtq_f32_s32(vmovl_s16(lr.val[0])));
+				vst1q_f32(right + i, vcvtq_f32_s32(vmovl_s16(lr.val[1])));
+			}
+#endif
+			for (; i < numFrames; ++i)
+			{
+				left[i] = in[i * 2];
+				right[i] = in[i * 2 + 1];
+			}
+		}
+		return;
+	}
+
+	if (mFormat == SF_FLOAT)
+	{
+		DownmixFrames(static_cast<const float*>(samples), numFrames, mNumChannels, mChannelGains.data(), scale, left, right);
+	}
+	else
+	{
+		DownmixFrames(static_cast<const int16_t*>(samples), numFrames, mNumChannels, mChannelGains.data(), scale, left, right);
+	}
+}
+
+//--------------------------------------------------------------------------
+void AudioConverter::Resample(std::vector<int16_t>& output)
+{
+	const size_t available = mLeft.size();
+	float* taps = mTaps.data();
+
+	// Each output frame needs mHalfTaps input frames on either side of its position
+	while ((mPosition >> 32) + mHalfTaps < available)
+	{
+		const size_t index = static_cast<size_t>(mPosition >> 32);
+		float left;
+		float right;
+
+		if (mStep == kFixedOne)
+		{
+			// Already at the output rate
+			left = mLeft[index];
+			right = mRight[index];
+		}
+		else
+		{
+			const uint32_t fraction = static_cast<uint32_t>(mPosition);
+			const uint phase = fraction >> kWeightBits;
+			const float weight = static_cast<float>(fraction & ((1u << kWeightBits) - 1)) * (1.0f / (1u << kWeightBits));
+
+			InterpolateTaps(&mCoefficients[phase * mNumTaps], &mCoefficients[(phase + 1) * mNumTaps], weight, taps, mNumTaps);
+
+			const size_t first = index + 1 - mHalfTaps;
+			left = DotProduct(taps, &mLeft[first], mNumTaps);
+			right = DotProduct(taps, &mRight[first], mNumTaps);
+		}
+
+		output.push_back(SaturateToInt16(left));
+		output.push_back(SaturateToInt16(right));
+
+		mPosition += mStep;
+	}
+
+	// Drop the input the next output frame no longer needs
+	size_t consumed = static_cast<size_t>(mPosition >> 32) + 1 - mHalfTaps;
+	if (consumed > available)
+	{
+		consumed = available;
+	}
+	mLeft.erase(mLeft.begin(), mLeft.begin() + consumed);
+	mRight.erase(mRight.begin(), mRight.begin() + consumed);
+	mPosition -= static_cast<uint64_t>(consumed) << 32;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+#include "twitchcore/types/errortypes.h"
+
+#include <vector>
+
+/**
+* AudioConverter - Converts audio in the format the client has (e.g. float samples at 48000 Hz
+* from Unity's OnAudioFilterRead, or 5.1 game audio) into the 2-channel packed 16-bit PCM at
+* 44100 samples/second that TTV_SubmitAudioSamples requires.
+*
+* The input is downmixed to stereo while it is deinterleaved and then resampled with a Kaiser windowed
+* sinc polyphase filter (flat to 19 kHz, about 80 dB stopband). Interpolating between the filter phases
+* allows any pair of rates. The filter gets longer with the input rate when downsampling, so converting
+* from high rates like 192000 Hz costs proportionally more.
+*
+* Channels are expected in the WAVE order (front left, front right, center, LFE, back left, back right,
+* side left, side right; 4 channels is front left, front right, back left, back right).
+*/
+class AudioConverter
+{
+public:
+	enum SampleFormat
+	{
+		SF_S16,		/* Interleaved signed 16-bit PCM */
+		SF_FLOAT	/* Interleaved 32-bit float in the range [-1, 1] */
+	};
+
+	AudioConverter();
+
+	/**
+	* Init - Set up the conversion. Must be called before converting and whenever the input format changes.
+	* @param[in] format - Format of the input samples
+	* @param[in] numChannels - Number of interleaved input channels
+	* @param[in] sampleRate - Input samples per second (per channel)
+	* @return - TTV_EC_SUCCESS if function succeeds; TTV_EC_INVALID_ARG if the format isn't supported
+	*/
+	TTV_ErrorCode Init(SampleFormat format, uint numChannels, uint sampleRate);
+
+	/**
+	* SetRateAdjustment - Compensate for the input clock running faster or slower than its nominal
+	* rate (see ClockDriftEstimator). The filter position carries over, so this can be changed between
+	* every call to Convert without audible artifacts. Init resets the adjustment to 1.
+	* @param[in] ratio - Actual input rate divided by the nominal input rate (e.g. 1.0001 for +100 ppm)
+	* @return - TTV_EC_SUCCESS if function succeeds; TTV_EC_INVALID_ARG if the ratio is out of range
+	*/
+	TTV_ErrorCode SetRateAdjustment(double ratio);
+
+	/**
+	* Convert - Convert a buffer of input samples. Because of the filter delay and the rate
+	* change the number of output samples will vary from call to call.
+	* @param[in] samples - The interleaved input samples
+	* @param[in] numSamples - Number of input samples (total NOT per channel)
+	* @param[out] output - The converted samples are appended to this buffer
+	* @return - TTV_EC_SUCCESS if function succeeds; error code otherwise
+	*/
+	TTV_ErrorCode Convert(const void* samples, uint numSamples, std::vector<int16_t>& output);
+
+	/**
+	* SubmitAudioSamples - Convert a buffer of input samples and pass the result to TTV_SubmitAudioSamples.
+	* @param[in] samples - The interleaved input samples
+	* @param[in] numSamples - Number of input samples (total NOT per channel)
+	* @return - TTV_EC_SUCCESS if function succeeds; error code otherwise
+	*/
+	TTV_ErrorCode SubmitAudioSamples(const void* samples, uint numSamples);
+
+private:
+	void Downmix(const void* samples, uint numFrames);
+	void Resample(std::vector<int16_t>& output);
+
+	std::vector<float> mCoefficients;	// (phases + 1) rows of filter taps
+	std::vector<float> mTaps;			// The taps interpolated for the current output frame
+	std::vector<float> mLeft;			// Downmixed input that has not been consumed by the filter yet
+	std::vector<float> mRight;
+	std::vector<float> mChannelGains;	// Left and right gain of each input channel
+	std::vector<int16_t> mOutput;
+	uint64_t mPosition;					// Filter position within mLeft/mRight in 32.32 fixed point
+	uint64_t mStep;						// Input frames per output frame in 32.32 fixed point
+	uint mNumTaps;						// Filter length in input frames
+	uint mHalfTaps;
+	SampleFormat mFormat;
+	uint mNumChannels;
+	uint mSampleRate;
+};
@@ -0,0 +1,296 @@
+#include <cmath>
+#include <cstdint>
+
+#include "audiosimd.h"
+#include "audiolevelmeter.h"
+
+namespace
+{
+	struct BlockStats
+	{
+		float peak;
+		double sumSquares;
+		uint clipped;
+	};
+}
+
+//--------------------------------------------------------------------------
+static inline uint CountBits(uint value)
+{
+	uint count = 0;
+	for (; value != 0; value &= value - 1)
+	{
+		++count;
+	}
+	return count;
+}
+
+//--------------------------------------------------------------------------
+static void Measure(const int16_t* samples, uint numSamples, BlockStats& stats)
+{
+	uint i = 0;
+	int maxValue = 0;
+	int minValue = 0;
+	uint64_t sumSquares = 0;
+	uint clipped = 0;
+
+#if AUDIO_SSE2
+	const __m128i fullScaleMax = _mm_set1_epi16(INT16_MAX);
+	const __m128i fullScaleMin = _mm_set1_epi16(INT16_MIN);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i vmax = zero;
+	__m128i vmin = zero;
+	__m128i vsum = zero;
+
+	for (; i + 8 <= numSamples; i += 8)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+		vmax = _mm_max_epi16(vmax, v);
+		vmin = _mm_min_epi16(vmin, v);
+
+		// Pairwise sums of squares fit in 32 unsigned bits, widen them before accumulating
+		__m128i squares = _mm_madd_epi16(v, v);
+		vsum = _mm_add_epi64(vsum, _mm_unpacklo_epi32(squares, zero));
+		vsum = _mm_add_epi64(vsum, _mm_unpackhi_epi32(squares, zero));
+
+		__m128i clip = _mm_or_si128(_mm_cmpeq_epi16(v, fullScaleMax), _mm_cmpeq_epi16(v, fullScaleMin));
+		clipped += CountBits(static_cast<uint>(_mm_movemask_epi8(clip))) / 2;
+	}
+
+	int16_t lanes[8];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vmax);
+	for (int k = 0; k < 8; ++k)
+	{
+		maxValue = lanes[k] > maxValue ? lanes[k] : maxValue;
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vmin);
+	for (int k = 0; k < 8; ++k)
+	{
+		minValue = lanes[k] < minValue ? lanes[k] : minValue;
+	}
+
+	uint64_t sums[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums), vsum);
+	sumSquares = sums[0] + sums[1];
+#elif AUDIO_NEON
+	int16x8_t vmax = vdupq_n_s16(0);
+	int16x8_t vmin = vdupq_n_s16(0);
+	int64x2_t vsum = vdupq_n_s64(0);
+	uint32x4_t vclipped = vdupq_n_u32(0);
+
+	for (; i + 8 <= numSamples; i += 8)
+	{
+		int16x8_t v = vld1q_s16(samples + i);
+		vmax = vmaxq_s16(vmax, v);
+		vmin = vminq_s16(vmin, v);
+
+		vsum = vpadalq_s32(vsum, vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+		vsum = vpadalq_s32(vsum, vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+
+		uint16x8_t clip = vorrq_u16(vceqq_s16(v, vdupq_n_s16(INT16_MAX)), vceqq_s16(v, vdupq_n_s16(INT16_MIN)));
+		vclipped = vpadalq_u16(vclipped, vshrq_n_u16(clip, 15));
+	}
+
+	int16_t lanes[8];
+	vst1q_s16(lanes, vmax);
+	for (int k = 0; k < 8; ++k)
+	{
+		maxValue = lanes[k] > maxValue ? lanes[k] : maxValue;
+	}
+	vst1q_s16(lanes, vmin);
+	for (int k = 0; k < 8; ++k)
+	{
+		minValue = lanes[k] < minValue ? lanes[k] : minValue;
+	}
+
+	sumSquares = static_cast<uint64_t>(vgetq_lane_s64(vsum, 0) + vgetq_lane_s64(vsum, 1));
+	uint32x2_t clipPair = vadd_u32(vget_low_u32(vclipped), vget_high_u32(vclipped));
+	clipped = vget_lane_u32(vpadd_u32(clipPair, clipPair), 0);
+#endif
+
+	for (; i < numSamples; ++i)
+	{
+		const int v = samples[i];
+		maxValue = v > maxValue ? v : maxValue;
+		minValue = v < minValue ? v : minValue;
+		sumSquares += static_cast<uint64_t>(v * v);
+		clipped += (v == INT16_MAX || v == INT16_MIN) ? 1 : 0;
+	}
+
+	const int peak = maxValue > -minValue ? maxValue : -minValue;
+	const float peakScaled = static_cast<float>(peak) / 32768.0f;
+	stats.peak = peakScaled > stats.peak ? peakScaled : stats.peak;
+	stats.sumSquares += static_cast<double>(sumSquares) / (32768.0 * 32768.0);
+	stats.clipped += clipped;
+}
+
+//--------------------------------------------------------------------------
+static void Measure(const float* samples, uint numSamples, BlockStats& stats)
+{
+	uint i = 0;
+	float peak = 0.0f;
+	float sumSquares = 0.0f;
+	uint clipped = 0;
+
+#if AUDIO_SSE2
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 fullScale = _mm_set1_ps(1.0f);
+	__m128 vpeak = _mm_setzero_ps();
+	__m128 vsum = _mm_setzero_ps();
+
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		__m128 v = _mm_loadu_ps(samples + i);
+		__m128 a = _mm_and_ps(v, absMask);
+		vpeak = _mm_max_ps(vpeak, a);
+		vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+		clipped += CountBits(static_cast<uint>(_mm_movemask_ps(_mm_cmpge_ps(a, fullScale))));
+	}
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, vpeak);
+	peak = lanes[0];
+	for (int k = 1; k < 4; ++k)
+	{
+		peak = lanes[k] > peak ? lanes[k] : peak;
+	}
+	_mm_storeu_ps(lanes, vsum);
+	sumSquares = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif AUDIO_NEON
+	float32x4_t vpeak = vdupq_n_f32(0.0f);
+	float32x4_t vsum = vdupq_n_f32(0.0f);
+	uint32x4_t vclipped = vdupq_n_u32(0);
+
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		float32x4_t v = vld1q_f32(samples + i);
+		float32x4_t a = vabsq_f32(v);
+		vpeak = vmaxq_f32(vpeak, a);
+		vsum = vmlaq_f32(vsum, v, v);
+		vclipped = vsubq_u32(vclipped, vcgeq_f32(a, vdupq_n_f32(1.0f)));
+	}
+
+	float32x2_t peakPair = vpmax_f32(vget_low_f32(vpeak), vget_high_f32(vpeak));
+	peak = vget_lane_f32(vpmax_f32(peakPair, peakPair), 0);
+	float32x2_t sumPair = vadd_f32(vget_low_f32(vsum), vget_high_f32(vsum));
+	sumSquares = vget_lane_f32(vpadd_f32(sumPair, sumPair), 0);
+	uint32x2_t clipPair = vadd_u32(vget_low_u32(vclipped), vget_high_u32(vclipped));
+	clipped = vget_lane_u32(vpadd_u32(clipPair, clipPair), 0);
+#endif
+
+	for (; i < numSamples; ++i)
+	{
+		const float a = fabsf(samples[i]);
+		peak = a > peak ? a : peak;
+		sumSquares += samples[i] * samples[i];
+		clipped += a >= 1.0f ? 1 : 0;
+	}
+
+	stats.peak = peak > stats.peak ? peak : stats.peak;
+	stats.sumSquares += sumSquares;
+	stats.clipped += clipped;
+}
+
+
+//--------------------------------------------------------------------------
+AudioLevelMeter::AudioLevelMeter(uint sampleRate, uint numChannels, uint intervalMs)
+: mIntervalSamples(static_cast<uint>(static_cast<uint64_t>(sampleRate) * numChannels * intervalMs / 1000))
+, mCount(0)
+, mPeak(0.0f)
+, mSumSquares(0.0)
+, mClipped(0)
+, mPublishedPeak(0.0f)
+, mPublishedRms(0.0f)
+, mPublishedClipped(0)
+, mSequence(0)
+, mNewLevels(false)
+{
+	if (mIntervalSamples == 0)
+	{
+		mIntervalSamples = 1;
+	}
+}
+
+//--------------------------------------------------------------------------
+template <typename SampleType>
+void AudioLevelMeter::Accumulate(const SampleType* samples, uint numSamples)
+{
+	while (numSamples > 0)
+	{
+		// Don't let a block straddle two intervals
+		const uint remaining = mIntervalSamples - mCount;
+		const uint count = numSamples < remaining ? numSamples : remaining;
+
+		BlockStats stats = { mPeak, mSumSquares, mClipped };
+		Measure(samples, count, stats);
+		mPeak = stats.peak;
+		mSumSquares = stats.sumSquares;
+		mClipped = stats.clipped;
+
+		mCount += count;
+		samples += count;
+		numSamples -= count;
+
+		if (mCount == mIntervalSamples)
+		{
+			Publish();
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+void AudioLevelMeter::Process(const int16_t* samples, uint numSamples)
+{
+	Accumulate(samples, numSamples);
+}
+
+//--------------------------------------------------------------------------
+void AudioLevelMeter::Process(const float* samples, uint numSamples)
+{
+	Accumulate(samples, numSamples);
+}
+
+//--------------------------------------------------------------------------
+void AudioLevelMeter::Publish()
+{
+	// Odd sequence numbers mark an update in progress so PollLevels never mixes two intervals
+	const uint sequence = mSequence.load(std::memory_order_relaxed);
+	mSequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	mPublishedPeak.store(mPeak, std::memory_order_relaxed);
+	mPublishedRms.store(static_cast<float>(sqrt(mSumSquares / mCount)), std::memory_order_relaxed);
+	mPublishedClipped.store(mClipped, std::memory_order_relaxed);
+
+	mSequence.store(sequence + 2, std::memory_order_release);
+	mNewLevels.store(true, std::memory_order_release);
+
+	mCount = 0;
+	mPeak = 0.0f;
+	mSumSquares = 0.0;
+	mClipped = 0;
+}
+
+//--------------------------------------------------------------------------
+bool AudioLevelMeter::PollLevels(Levels& levels)
+{
+	const bool newLevels = mNewLevels.exchange(false, std::memory_order_acquire);
+
+	// Retry if the processing thread published a new interval while the levels were being read
+	uint before;
+	uint after;
+	do
+	{
+		before = mSequence.load(std::memory_order_acquire);
+
+		levels.peak = mPublishedPeak.load(std::memory_order_relaxed);
+		levels.rms = mPublishedRms.load(std::memory_order_relaxed);
+		levels.clippedSamples = mPublishedClipped.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = mSequence.load(std::memory_order_relaxed);
+	}
+	while ((before & 1) != 0 || before != after);
+
+	return newLevels;
+}
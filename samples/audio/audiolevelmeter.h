@@ -0,0 +1,66 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+
+#include <atomic>
+
+/**
+* AudioLevelMeter - Peak, RMS and clip metering for driving mic / game audio meters in a broadcast UI.
+*
+* Run the samples you submit (or are about to mix) through Process on the audio thread and poll
+* PollLevels from the UI thread. The levels are measured with SIMD kernels over fixed intervals
+* so the meter costs almost nothing on top of the audio you already handle.
+*/
+class AudioLevelMeter
+{
+public:
+	struct Levels
+	{
+		float peak;				/* Highest absolute sample value in the interval (0.0 to 1.0 of full scale) */
+		float rms;				/* Root mean square level of the interval (0.0 to 1.0 of full scale) */
+		uint clippedSamples;	/* Number of samples at full scale in the interval */
+	};
+
+	/**
+	* @param[in] sampleRate - Sample rate of the audio (per channel)
+	* @param[in] numChannels - Number of interleaved channels (all channels are metered together)
+	* @param[in] intervalMs - Length of the interval the levels are measured over
+	*/
+	AudioLevelMeter(uint sampleRate, uint numChannels, uint intervalMs);
+
+	/**
+	* Process - Meter a buffer of interleaved 16-bit PCM samples. Call from a single thread.
+	*/
+	void Process(const int16_t* samples, uint numSamples);
+
+	/**
+	* Process - Meter a buffer of interleaved float samples in the range [-1, 1]. Call from a single thread.
+	*/
+	void Process(const float* samples, uint numSamples);
+
+	/**
+	* PollLevels - Get the levels of the most recently completed interval. Can be called from any thread.
+	* @return - true if an interval completed since the previous call
+	*/
+	bool PollLevels(Levels& levels);
+
+private:
+	template <typename SampleType>
+	void Accumulate(const SampleType* samples, uint numSamples);
+	void Publish();
+
+	uint mIntervalSamples;
+
+	// Running totals of the current interval, only touched by the processing thread
+	uint mCount;
+	float mPeak;
+	double mSumSquares;
+	uint mClipped;
+
+	// Levels of the last completed interval, guarded by a sequence counter that is odd while they are updated
+	std::atomic<float> mPublishedPeak;
+	std::atomic<float> mPublishedRms;
+	std::atomic<uint> mPublishedClipped;
+	std::atomic<uint> mSequence;
+	std::atomic<bool> mNewLevels;
+};
@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <cstddef>
+
+#include "audiosimd.h"
+#include "audiomixer.h"
+
+namespace
+{
+	const float kInt16Min = -32768.0f;
+	const float kInt16Max = 32767.0f;
+}
+
+//--------------------------------------------------------------------------
+static inline int16_t SaturateToInt16(float sample)
+{
+	if (sample <= kInt16Min)
+	{
+		return INT16_MIN;
+	}
+	if (sample >= kInt16Max)
+	{
+		return INT16_MAX;
+	}
+
+	// Round half away from zero, the SIMD paths round the same way so results don't depend on buffer length
+	return static_cast<int16_t>(sample < 0.0f ? sample - 0.5f : sample + 0.5f);
+}
+
+//--------------------------------------------------------------------------
+static inline float Clamp(float sample)
+{
+	return sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+}
+
+//--------------------------------------------------------------------------
+void MixAudio(int16_t* output, const int16_t* const* sources, const float* gains, uint numSources, size_t numSamples)
+{
+	size_t i = 0;
+
+#if AUDIO_SSE2
+	const __m128 minValue = _mm_set1_ps(kInt16Min);
+	const __m128 maxValue = _mm_set1_ps(kInt16Max);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	for (; i + 8 <= numSamples; i += 8)
+	{
+		__m128 lo = _mm_setzero_ps();
+		__m128 hi = _mm_setzero_ps();
+
+		for (uint s = 0; s < numSources; ++s)
+		{
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[s] + i));
+			__m128 gain = _mm_set1_ps(gains[s]);
+
+			// Sign extend to 32 bits by moving each sample into the upper half and shifting back down
+			__m128 inLo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16));
+			__m128 inHi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16));
+
+			lo = _mm_add_ps(lo, _mm_mul_ps(inLo, gain));
+			hi = _mm_add_ps(hi, _mm_mul_ps(inHi, gain));
+		}
+
+		// Clamp before converting since out of range floats convert to INT32_MIN
+		lo = _mm_min_ps(_mm_max_ps(lo, minValue), maxValue);
+		hi = _mm_min_ps(_mm_max_ps(hi, minValue), maxValue);
+
+		// Round half away from zero and truncate, _mm_cvtps_epi32 would round half to even
+		lo = _mm_add_ps(lo, _mm_or_ps(_mm_and_ps(lo, signMask), half));
+		hi = _mm_add_ps(hi, _mm_or_ps(_mm_and_ps(hi, signMask), half));
+
+		__m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+	}
+#elif AUDIO_NEON
+	const uint32x4_t signMask = vdupq_n_u32(0x80000000);
+	const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+
+	for (; i + 8 <= numSamples; i += 8)
+	{
+		float32x4_t lo = vdupq_n_f32(0.0f);
+		float32x4_t hi = vdupq_n_f32(0.0f);
+
+		for (uint s = 0; s < numSources; ++s)
+		{
+			int16x8_t in = vld1q_s16(sources[s] + i);
+
+			lo = vmlaq_n_f32(lo, vcvtq_f32_s32(vmovl_s16(vget_low_s16(in))), gains[s]);
+			hi = vmlaq_n_f32(hi, vcvtq_f32_s32(vmovl_s16(vget_high_s16(in))), gains[s]);
+		}
+
+		// Round half away from zero, then narrow with saturation
+		lo = vaddq_f32(lo, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(lo), signMask), half)));
+		hi = vaddq_f32(hi, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(hi), signMask), half)));
+
+		int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)), vqmovn_s32(vcvtq_s32_f32(hi)));
+		vst1q_s16(output + i, packed);
+	}
+#endif
+
+	for (; i < numSamples; ++i)
+	{
+		float sum = 0.0f;
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum += static_cast<float>(sources[s][i]) * gains[s];
+		}
+		output[i] = SaturateToInt16(sum);
+	}
+}
+
+//--------------------------------------------------------------------------
+void MixAudio(float* output, const float* const* sources, const float* gains, uint numSources, size_t numSamples)
+{
+	size_t i = 0;
+
+#if AUDIO_SSE2
+	const __m128 minValue = _mm_set1_ps(-1.0f);
+	const __m128 maxValue = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(sources[s] + i), _mm_set1_ps(gains[s])));
+		}
+		_mm_storeu_ps(output + i, _mm_min_ps(_mm_max_ps(sum, minValue), maxValue));
+	}
+#elif AUDIO_NEON
+	const float32x4_t minValue = vdupq_n_f32(-1.0f);
+	const float32x4_t maxValue = vdupq_n_f32(1.0f);
+
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum = vmlaq_n_f32(sum, vld1q_f32(sources[s] + i), gains[s]);
+		}
+		vst1q_f32(output + i, vminq_f32(vmaxq_f32(sum, minValue), maxValue));
+	}
+#endif
+
+	for (; i < numSamples; ++i)
+	{
+		float sum = 0.0f;
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum += sources[s][i] * gains[s];
+		}
+		output[i] = Clamp(sum);
+	}
+}
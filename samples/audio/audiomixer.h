@@ -0,0 +1,33 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+
+/**
+* Mixing of client audio sources (e.g. music, effects and voice chat) into the single
+* passthrough stream that is submitted with TTV_SubmitAudioSamples. Each source is scaled
+* by its gain, the sources are summed at full precision and the result is saturated once,
+* so loud passages clip instead of wrapping around.
+*
+* The buffers must hold the same number of interleaved samples in the same channel layout.
+* The output buffer may be the same as one of the sources.
+*/
+
+/**
+* MixAudio - Mixes 16-bit PCM sources into a 16-bit PCM output
+* @param[out] output - Receives numSamples saturated samples
+* @param[in] sources - The source buffers
+* @param[in] gains - The gain to apply to each source (e.g. 0.0 to 1.0 like TTV_SetVolume)
+* @param[in] numSources - Number of entries in sources and gains
+* @param[in] numSamples - Number of samples in each buffer (total NOT per channel)
+*/
+void MixAudio(int16_t* output, const int16_t* const* sources, const float* gains, uint numSources, size_t numSamples);
+
+/**
+* MixAudio - Mixes floating point sources into a floating point output clamped to [-1, 1]
+* @param[out] output - Receives numSamples clamped samples
+* @param[in] sources - The source buffers
+* @param[in] gains - The gain to apply to each source
+* @param[in] numSources - Number of entries in sources and gains
+* @param[in] numSamples - Number of samples in each buffer (total NOT per channel)
+*/
+void MixAudio(float* output, const float* const* sources, const float* gains, uint numSources, size_t numSamples);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+* AudioRingBuffer - Single producer / single consumer queue of audio samples.
+*
+* Audio callbacks (Unity's audio thread, WASAPI or CoreAudio render callbacks) must never block.
+* Write the samples to this buffer from the callback and call TTV_SubmitAudioSamples from a thread
+* of your own that drains it with Read. Write and Read are wait-free and never allocate; all memory
+* is allocated up front by the constructor.
+*
+* Exactly one thread may call Write and exactly one other thread may call Read.
+*/
+template <typename SampleType>
+class AudioRingBuffer
+{
+public:
+	/**
+	* @param[in] capacity - Number of samples (total NOT per channel) the buffer can hold. Rounded up to a power of two.
+	*/
+	explicit AudioRingBuffer(size_t capacity)
+	: mWritePosition(0)
+	, mReadPosition(0)
+	, mOverruns(0)
+	, mDroppedSamples(0)
+	{
+		size_t size = 1;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		mBuffer.resize(size);
+		mMask = size - 1;
+	}
+
+	/**
+	* Write - Producer side. If there isn't room for all of the samples none are written so that
+	* channels stay interleaved correctly, and the overrun is counted.
+	* @return - The number of samples written (numSamples or 0)
+	*/
+	size_t Write(const SampleType* samples, size_t numSamples)
+	{
+		const size_t write = mWritePosition.load(std::memory_order_relaxed);
+		const size_t read = mReadPosition.load(std::memory_order_acquire);
+
+		if (numSamples > mBuffer.size() - (write - read))
+		{
+			mOverruns.fetch_add(1, std::memory_order_relaxed);
+			mDroppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+			return 0;
+		}
+
+		Copy(write & mMask, samples, numSamples);
+		mWritePosition.store(write + numSamples, std::memory_order_release);
+
+		return numSamples;
+	}
+
+	/**
+	* Read - Consumer side. Reads up to maxSamples of the oldest samples.
+	* @return - The number of samples read
+	*/
+	size_t Read(SampleType* samples, size_t maxSamples)
+	{
+		const size_t read = mReadPosition.load(std::memory_order_relaxed);
+		const size_t write = mWritePosition.load(std::memory_order_acquire);
+
+		size_t count = write - read;
+		if (count > maxSamples)
+		{
+			count = maxSamples;
+		}
+
+		const size_t start = read & mMask;
+		const size_t first = count < mBuffer.size() - start ? count : mBuffer.size() - start;
+		memcpy(samples, &mBuffer[start], first * sizeof(SampleType));
+		memcpy(samples + first, &mBuffer[0], (count - first) * sizeof(SampleType));
+
+		mReadPosition.store(read + count, std::memory_order_release);
+
+		return count;
+	}
+
+	/**
+	* GetReadAvailable - The number of samples waiting to be read
+	*/
+	size_t GetReadAvailable() const
+	{
+		return mWritePosition.load(std::memory_order_acquire) - mReadPosition.load(std::memory_order_acquire);
+	}
+
+	/**
+	* GetOverrunCount - The number of writes that were dropped because the consumer fell behind
+	*/
+	uint64_t GetOverrunCount() const { return mOverruns.load(std::memory_order_relaxed); }
+
+	/**
+	* GetDroppedSampleCount - The total number of samples in the dropped writes
+	*/
+	uint64_t GetDroppedSampleCount() const { return mDroppedSamples.load(std::memory_order_relaxed); }
+
+private:
+	void Copy(size_t start, const SampleType* samples, size_t numSamples)
+	{
+		const size_t first = numSamples < mBuffer.size() - start ? numSamples : mBuffer.size() - start;
+		memcpy(&mBuffer[start], samples, first * sizeof(SampleType));
+		memcpy(&mBuffer[0], samples + first, (numSamples - first) * sizeof(SampleType));
+	}
+
+	// Not copyable
+	AudioRingBuffer(const AudioRingBuffer&);
+	AudioRingBuffer& operator=(const AudioRingBuffer&);
+
+	std::vector<SampleType> mBuffer;
+	size_t mMask;
+
+	// Keep the producer and consumer positions on separate cache lines
+	std::atomic<size_t> mWritePosition;
+	char mWritePadding[64];
+	std::atomic<size_t> mReadPosition;
+	char mReadPadding[64];
+
+	std::atomic<uint64_t> mOverruns;
+	std::atomic<uint64_t> mDroppedSamples;
+};
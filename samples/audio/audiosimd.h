@@ -0,0 +1,11 @@
+// Selects the SIMD instruction set used by the audio helpers
+
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define AUDIO_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#	include <arm_neon.h>
+#	define AUDIO_NEON 1
+#endif
@@ -0,0 +1,112 @@
+#include <cstdint>
+
+#include "clockdriftestimator.h"
+
+namespace
+{
+	const uint64_t kPointIntervalMs = 1000;		// Record at most one measurement per second
+	const uint kMaxPoints = 600;				// Regress over the last 10 minutes
+	const uint64_t kMinSpanMs = 30000;			// Callback jitter dominates over shorter spans
+	const double kMaxSkew = 0.005;				// Estimates beyond 5000 ppm are clamped
+}
+
+//--------------------------------------------------------------------------
+ClockDriftEstimator::ClockDriftEstimator(uint nominalSampleRate)
+: mPoints(kMaxPoints)
+, mNominalSampleRate(nominalSampleRate)
+{
+	Reset();
+}
+
+//--------------------------------------------------------------------------
+void ClockDriftEstimator::Reset()
+{
+	mFirstPoint = 0;
+	mNumPoints = 0;
+	mTotalFrames = 0;
+	mLastPointTimeMs = 0;
+	mRateRatio.store(1.0, std::memory_order_release);
+	mHasEstimate.store(false, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------
+void ClockDriftEstimator::AddSamples(uint64_t streamTimeMs, uint numFrames)
+{
+	// The stream clock restarted
+	if (mNumPoints > 0 && streamTimeMs < mLastPointTimeMs)
+	{
+		Reset();
+	}
+
+	mTotalFrames += numFrames;
+
+	if (mNumPoints > 0 && streamTimeMs - mLastPointTimeMs < kPointIntervalMs)
+	{
+		return;
+	}
+
+	if (mNumPoints == kMaxPoints)
+	{
+		mFirstPoint = (mFirstPoint + 1) % kMaxPoints;
+		--mNumPoints;
+	}
+
+	Point& point = mPoints[(mFirstPoint + mNumPoints) % kMaxPoints];
+	point.timeMs = streamTimeMs;
+	point.frames = mTotalFrames;
+	++mNumPoints;
+	mLastPointTimeMs = streamTimeMs;
+
+	Estimate();
+}
+
+//--------------------------------------------------------------------------
+void ClockDriftEstimator::Estimate()
+{
+	const Point& first = mPoints[mFirstPoint];
+	if (mNumPoints < 2 || mLastPointTimeMs - first.timeMs < kMinSpanMs || mNominalSampleRate == 0)
+	{
+		return;
+	}
+
+	// Least squares fit of frames against seconds, relative to the oldest point to keep precision
+	double meanTime = 0.0;
+	double meanFrames = 0.0;
+	for (uint i = 0; i < mNumPoints; ++i)
+	{
+		const Point& point = mPoints[(mFirstPoint + i) % kMaxPoints];
+		meanTime += static_cast<double>(point.timeMs - first.timeMs) / 1000.0;
+		meanFrames += static_cast<double>(point.frames - first.frames);
+	}
+	meanTime /= mNumPoints;
+	meanFrames /= mNumPoints;
+
+	double covariance = 0.0;
+	double variance = 0.0;
+	for (uint i = 0; i < mNumPoints; ++i)
+	{
+		const Point& point = mPoints[(mFirstPoint + i) % kMaxPoints];
+		const double t = static_cast<double>(point.timeMs - first.timeMs) / 1000.0 - meanTime;
+		const double x = static_cast<double>(point.frames - first.frames) - meanFrames;
+		covariance += t * x;
+		variance += t * t;
+	}
+
+	if (variance <= 0.0)
+	{
+		return;
+	}
+
+	double ratio = covariance / variance / mNominalSampleRate;
+	if (ratio < 1.0 - kMaxSkew)
+	{
+		ratio = 1.0 - kMaxSkew;
+	}
+	else if (ratio > 1.0 + kMaxSkew)
+	{
+		ratio = 1.0 + kMaxSkew;
+	}
+
+	mRateRatio.store(ratio, std::memory_order_release);
+	mHasEstimate.store(true, std::memory_order_release);
+}
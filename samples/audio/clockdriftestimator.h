@@ -0,0 +1,78 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+
+#include <atomic>
+#include <vector>
+
+/**
+* ClockDriftEstimator - Measures how fast an audio device really delivers samples compared to the
+* stream clock. TTV_SubmitAudioSamples assumes the samples are contiguous at exactly 44100 Hz, so a
+* device clock that is off by only 50 ppm moves the audio 0.5 seconds out of sync over an
+* almost three-hour broadcast.
+*
+* Call AddSamples each time a buffer arrives from the device, passing the stream time from
+* TTV_GetStreamTime. A linear regression of the number of sample frames received against the
+* stream time over the last several minutes gives the real device rate. Pass GetRateRatio to
+* AudioConverter::SetRateAdjustment so the resampler absorbs the drift instead of samples having
+* to be dropped or inserted.
+*
+* AddSamples doesn't allocate so it can be called from the audio callback. Call AddSamples and Reset
+* from one thread; HasEstimate, GetRateRatio and GetSkewPpm can be called from any thread (e.g. the
+* one running the AudioConverter).
+*/
+class ClockDriftEstimator
+{
+public:
+	/**
+	* @param[in] nominalSampleRate - The sample rate the device claims to run at (per channel)
+	*/
+	explicit ClockDriftEstimator(uint nominalSampleRate);
+
+	/**
+	* Reset - Discard all measurements (e.g. when the broadcast is restarted or the device changes)
+	*/
+	void Reset();
+
+	/**
+	* AddSamples - Record that sample frames arrived from the device.
+	* @param[in] streamTimeMs - The current stream time in milliseconds (see TTV_GetStreamTime)
+	* @param[in] numFrames - Number of sample frames (per channel) that arrived
+	*/
+	void AddSamples(uint64_t streamTimeMs, uint numFrames);
+
+	/**
+	* HasEstimate - True once enough time has been measured for the estimate to be meaningful
+	*/
+	bool HasEstimate() const { return mHasEstimate.load(std::memory_order_acquire); }
+
+	/**
+	* GetRateRatio - The measured device rate divided by the nominal rate, 1.0 until there is an estimate
+	*/
+	double GetRateRatio() const { return mRateRatio.load(std::memory_order_acquire); }
+
+	/**
+	* GetSkewPpm - The measured clock skew in parts per million (positive when the device is fast)
+	*/
+	double GetSkewPpm() const { return (GetRateRatio() - 1.0) * 1000000.0; }
+
+private:
+	struct Point
+	{
+		uint64_t timeMs;
+		uint64_t frames;
+	};
+
+	void Estimate();
+
+	std::vector<Point> mPoints;		// Ring of measurements, allocated up front
+	uint mFirstPoint;
+	uint mNumPoints;
+	uint64_t mTotalFrames;
+	uint64_t mLastPointTimeMs;
+	uint mNominalSampleRate;
+
+	// Results, published to other threads
+	std::atomic<double> mRateRatio;
+	std::atomic<bool> mHasEstimate;
+};
@@ -0,0 +1,595 @@
+// audiobench.cpp : Checks the SIMD audio helpers in samples/audio against scalar reference
+// implementations and times them, and checks the drift estimation and alignment logic.
+//
+
+#include "stdafx.h"
+#include "audioaligner.h"
+#include "audioconverter.h"
+#include "audiolevelmeter.h"
+#include "audiomixer.h"
+#include "clockdriftestimator.h"
+#include "twitchsdk.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const uint kNumSources = 4;
+	const size_t kNumSamples = 44100 * 2;	// One second of stereo audio
+	const uint kBenchmarkIterations = 200;
+	const uint kOutputSampleRate = 44100;
+	const double kPi = 3.14159265358979323846;
+
+	std::mt19937 gRandom(1234);
+
+	std::vector<int16_t> gSubmittedSamples;	// Everything passed to TTV_SubmitAudioSamples
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Records the submitted audio instead of streaming it
+//////////////////////////////////////////////////////////////////////////
+TTV_ErrorCode TTV_SubmitAudioSamples(const int16_t* samplesBuffer, uint numSamples)
+{
+	gSubmittedSamples.insert(gSubmittedSamples.end(), samplesBuffer, samplesBuffer + numSamples);
+	return TTV_EC_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Scalar references, computed in double precision
+//////////////////////////////////////////////////////////////////////////
+void MixReference(int16_t* output, const int16_t* const* sources, const float* gains, uint numSources, size_t numSamples)
+{
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		double sum = 0.0;
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum += static_cast<double>(sources[s][i]) * gains[s];
+		}
+
+		// Round half away from zero and saturate
+		sum = sum < 0.0 ? sum - 0.5 : sum + 0.5;
+		sum = sum < -32768.0 ? -32768.0 : (sum > 32767.0 ? 32767.0 : sum);
+		output[i] = static_cast<int16_t>(sum);
+	}
+}
+
+void MixReference(float* output, const float* const* sources, const float* gains, uint numSources, size_t numSamples)
+{
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		double sum = 0.0;
+		for (uint s = 0; s < numSources; ++s)
+		{
+			sum += static_cast<double>(sources[s][i]) * gains[s];
+		}
+		output[i] = static_cast<float>(sum < -1.0 ? -1.0 : (sum > 1.0 ? 1.0 : sum));
+	}
+}
+
+template <typename SampleType>
+AudioLevelMeter::Levels MeasureReference(const SampleType* samples, size_t numSamples, double fullScale)
+{
+	double peak = 0.0;
+	double sumSquares = 0.0;
+	uint clipped = 0;
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		const double value = static_cast<double>(samples[i]);
+		const double magnitude = fabs(value);
+		peak = magnitude > peak ? magnitude : peak;
+		sumSquares += value * value;
+		const bool clip = fullScale > 1.0 ? (value == INT16_MAX || value == INT16_MIN) : magnitude >= 1.0;
+		clipped += clip ? 1 : 0;
+	}
+
+	AudioLevelMeter::Levels levels;
+	levels.peak = static_cast<float>(peak / fullScale);
+	levels.rms = static_cast<float>(sqrt(sumSquares / numSamples) / fullScale);
+	levels.clippedSamples = clipped;
+	return levels;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Helpers
+//////////////////////////////////////////////////////////////////////////
+template <typename SampleType>
+void GetPointers(std::vector<SampleType>* buffers, const SampleType** pointers, size_t offset)
+{
+	for (uint s = 0; s < kNumSources; ++s)
+	{
+		pointers[s] = buffers[s].data() + offset;
+	}
+}
+
+template <typename Function>
+double TimeNsPerSample(Function function)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint i = 0; i < kBenchmarkIterations; ++i)
+	{
+		function();
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start);
+
+	return static_cast<double>(elapsed.count()) / (static_cast<double>(kBenchmarkIterations) * kNumSamples);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+//////////////////////////////////////////////////////////////////////////
+bool TestMixInt16()
+{
+	std::uniform_int_distribution<int> sampleDistribution(INT16_MIN, INT16_MAX);
+	std::vector<int16_t> sources[kNumSources];
+	for (uint s = 0; s < kNumSources; ++s)
+	{
+		sources[s].resize(kNumSamples);
+		for (size_t i = 0; i < kNumSamples; ++i)
+		{
+			sources[s][i] = static_cast<int16_t>(sampleDistribution(gRandom));
+		}
+	}
+
+	// Gains above 1 so saturation is exercised too
+	const float gains[kNumSources] = { 1.0f, 0.5f, 0.75f, 1.5f };
+	const int16_t* pointers[kNumSources];
+	GetPointers(sources, pointers, 0);
+
+	std::vector<int16_t> expected(kNumSamples);
+	std::vector<int16_t> actual(kNumSamples);
+	MixReference(expected.data(), pointers, gains, kNumSources, kNumSamples);
+	MixAudio(actual.data(), pointers, gains, kNumSources, kNumSamples);
+
+	// Float accumulation may differ from the double reference by one step when a sum lands close to .5
+	int maxError = 0;
+	for (size_t i = 0; i < kNumSamples; ++i)
+	{
+		const int error = abs(expected[i] - actual[i]);
+		maxError = error > maxError ? error : maxError;
+	}
+
+	// The SIMD body and the scalar tail must give identical results, whatever the length and alignment
+	bool consistent = true;
+	std::vector<int16_t> partial(kNumSamples);
+	for (size_t offset = 0; offset < 8 && consistent; ++offset)
+	{
+		for (size_t length = 1; length <= 37 && consistent; ++length)
+		{
+			GetPointers(sources, pointers, offset);
+			MixAudio(partial.data(), pointers, gains, kNumSources, length);
+			for (size_t i = 0; i < length; ++i)
+			{
+				consistent = consistent && partial[i] == actual[offset + i];
+			}
+		}
+	}
+
+	GetPointers(sources, pointers, 0);
+	const double referenceNs = TimeNsPerSample([&]() { MixReference(expected.data(), pointers, gains, kNumSources, kNumSamples); });
+	const double mixNs = TimeNsPerSample([&]() { MixAudio(actual.data(), pointers, gains, kNumSources, kNumSamples); });
+
+	const bool passed = maxError <= 1 && consistent;
+	printf("MixAudio int16: max error %d LSB, %s, %.3f ns/sample (reference %.3f ns/sample, %.1fx) ... %s\n",
+		maxError, consistent ? "consistent" : "INCONSISTENT", mixNs, referenceNs, referenceNs / mixNs, passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+bool TestMixFloat()
+{
+	std::uniform_real_distribution<float> sampleDistribution(-1.0f, 1.0f);
+	std::vector<float> sources[kNumSources];
+	for (uint s = 0; s < kNumSources; ++s)
+	{
+		sources[s].resize(kNumSamples);
+		for (size_t i = 0; i < kNumSamples; ++i)
+		{
+			sources[s][i] = sampleDistribution(gRandom);
+		}
+	}
+
+	const float gains[kNumSources] = { 1.0f, 0.5f, 0.75f, 1.5f };
+	const float* pointers[kNumSources];
+	GetPointers(sources, pointers, 0);
+
+	std::vector<float> expected(kNumSamples);
+	std::vector<float> actual(kNumSamples);
+	MixReference(expected.data(), pointers, gains, kNumSources, kNumSamples);
+	MixAudio(actual.data(), pointers, gains, kNumSources, kNumSamples);
+
+	double maxError = 0.0;
+	for (size_t i = 0; i < kNumSamples; ++i)
+	{
+		const double error = fabs(static_cast<double>(expected[i]) - actual[i]);
+		maxError = error > maxError ? error : maxError;
+	}
+
+	const double referenceNs = TimeNsPerSample([&]() { MixReference(expected.data(), pointers, gains, kNumSources, kNumSamples); });
+	const double mixNs = TimeNsPerSample([&]() { MixAudio(actual.data(), pointers, gains, kNumSources, kNumSamples); });
+
+	// A few float rounding steps of a sum of kNumSources terms
+	const bool passed = maxError <= 1e-6;
+	printf("MixAudio float: max error %.2e, %.3f ns/sample (reference %.3f ns/sample, %.1fx) ... %s\n",
+		maxError, mixNs, referenceNs, referenceNs / mixNs, passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+/**
+* Converts one second of a stereo sine at the given frequency and returns the level of the output
+* at outputFrequency in dB relative to the input, measured with a Hann windowed DFT bin.
+*/
+double MeasureConvertedLevel(uint sampleRate, double frequency, double outputFrequency)
+{
+	AudioConverter converter;
+	converter.Init(AudioConverter::SF_FLOAT, 2, sampleRate);
+
+	const float amplitude = 0.5f;
+	const uint chunkFrames = sampleRate / 100;
+	std::vector<float> input(chunkFrames * 2);
+	std::vector<int16_t> output;
+	for (uint frame = 0; frame < sampleRate; frame += chunkFrames)
+	{
+		for (uint i = 0; i < chunkFrames; ++i)
+		{
+			const float sample = amplitude * static_cast<float>(sin(2.0 * kPi * frequency * (frame + i) / sampleRate));
+			input[i * 2] = sample;
+			input[i * 2 + 1] = sample;
+		}
+		converter.Convert(input.data(), static_cast<uint>(input.size()), output);
+	}
+
+	// Skip the start where the filter is still filling up
+	const size_t skip = 4096;
+	const size_t count = output.size() / 2 - skip;
+	double re = 0.0;
+	double im = 0.0;
+	double windowSum = 0.0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double window = 0.5 - 0.5 * cos(2.0 * kPi * i / count);
+		const double sample = output[(skip + i) * 2] / 32768.0;
+		const double phase = 2.0 * kPi * outputFrequency * i / kOutputSampleRate;
+		re += window * sample * cos(phase);
+		im += window * sample * sin(phase);
+		windowSum += window;
+	}
+
+	const double level = 2.0 * sqrt(re * re + im * im) / windowSum;
+	return 20.0 * log10(level / amplitude + 1e-12);
+}
+
+bool TestConverter()
+{
+	bool passed = true;
+	const uint rates[] = { 22050, 32000, 48000, 96000, 192000 };
+	for (uint r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+	{
+		const uint rate = rates[r];
+		const double lowerRate = rate < kOutputSampleRate ? rate : kOutputSampleRate;
+
+		// Passband must be flat
+		const double passband[] = { 1000.0, lowerRate * 0.42 };
+		double worstPassband = 0.0;
+		for (uint i = 0; i < 2; ++i)
+		{
+			const double level = MeasureConvertedLevel(rate, passband[i], passband[i]);
+			worstPassband = fabs(level) > fabs(worstPassband) ? level : worstPassband;
+		}
+
+		// Tones above the output Nyquist frequency alias when downsampling, tones close to the input
+		// Nyquist frequency leave images above it when upsampling
+		const double downsampling[] = { 22500.0, 25000.0, 30000.0, rate * 0.45 };
+		const double upsampling[] = { rate * 0.46, rate * 0.48 };
+		const double* stopband = rate > kOutputSampleRate ? downsampling : upsampling;
+		const uint numStopband = rate > kOutputSampleRate ? 4 : 2;
+
+		double worstStopband = -200.0;
+		for (uint i = 0; i < numStopband; ++i)
+		{
+			// Only tones the input can carry that actually land in the stopband
+			const double frequency = stopband[i];
+			if (frequency >= rate * 0.5 || (rate > kOutputSampleRate && frequency <= kOutputSampleRate * 0.5))
+			{
+				continue;
+			}
+
+			// Fold the tone (or its image) into the output band
+			double alias = fmod(rate > kOutputSampleRate ? frequency : rate - frequency, static_cast<double>(kOutputSampleRate));
+			alias = alias > kOutputSampleRate * 0.5 ? kOutputSampleRate - alias : alias;
+
+			const double level = MeasureConvertedLevel(rate, frequency, alias);
+			worstStopband = level > worstStopband ? level : worstStopband;
+		}
+
+		const bool ratePassed = fabs(worstPassband) <= 0.1 && worstStopband <= -70.0;
+		printf("AudioConverter %u Hz: passband %+.3f dB, worst alias %.1f dB ... %s\n", rate, worstPassband, worstStopband, ratePassed ? "passed" : "FAILED");
+		passed = passed && ratePassed;
+	}
+
+	return passed;
+}
+
+
+/**
+* Converts 5.1 audio, and the same audio downmixed to stereo in double precision beforehand, in uneven
+* chunks. Both go through the same resampler so the results must match.
+*/
+template <typename SampleType>
+bool CheckDownmix(AudioConverter::SampleFormat format, double fullScale, double& nsPerFrame)
+{
+	const uint kChannels = 6;
+	const uint kNumFrames = kOutputSampleRate;
+	const uint kRate = 48000;
+
+	// WAVE order FL, FR, C, LFE, BL, BR. The LFE is dropped and the gains are normalized by 1 + 2 * -3 dB.
+	const double minusThreeDb = sqrt(0.5);
+	const double normalize = 1.0 / (1.0 + 2.0 * minusThreeDb);
+	const double gains[kChannels][2] = { { 1.0, 0.0 }, { 0.0, 1.0 }, { minusThreeDb, minusThreeDb }, { 0.0, 0.0 }, { minusThreeDb, 0.0 }, { 0.0, minusThreeDb } };
+
+	std::uniform_real_distribution<double> sampleDistribution(-0.9, 0.9);
+	std::vector<SampleType> input(kNumFrames * kChannels);
+	std::vector<float> reference(kNumFrames * 2);
+	for (uint i = 0; i < kNumFrames; ++i)
+	{
+		double left = 0.0;
+		double right = 0.0;
+		for (uint c = 0; c < kChannels; ++c)
+		{
+			input[i * kChannels + c] = static_cast<SampleType>(sampleDistribution(gRandom) * fullScale);
+			left += static_cast<double>(input[i * kChannels + c]) / fullScale * gains[c][0] * normalize;
+			right += static_cast<double>(input[i * kChannels + c]) / fullScale * gains[c][1] * normalize;
+		}
+		reference[i * 2] = static_cast<float>(left);
+		reference[i * 2 + 1] = static_cast<float>(right);
+	}
+
+	AudioConverter surround;
+	AudioConverter stereo;
+	surround.Init(format, kChannels, kRate);
+	stereo.Init(AudioConverter::SF_FLOAT, 2, kRate);
+
+	std::vector<int16_t> expected;
+	std::vector<int16_t> actual;
+	for (uint frame = 0, chunk = 1; frame < kNumFrames; chunk = chunk % 37 + 1)
+	{
+		const uint count = chunk < kNumFrames - frame ? chunk : kNumFrames - frame;
+		surround.Convert(input.data() + frame * kChannels, count * kChannels, actual);
+		stereo.Convert(reference.data() + frame * 2, count * 2, expected);
+		frame += count;
+	}
+
+	int maxError = expected.size() == actual.size() ? 0 : INT16_MAX;
+	for (size_t i = 0; i < expected.size() && i < actual.size(); ++i)
+	{
+		const int error = abs(expected[i] - actual[i]);
+		maxError = error > maxError ? error : maxError;
+	}
+
+	std::vector<int16_t> output;
+	nsPerFrame = TimeNsPerSample([&]() { output.clear(); surround.Convert(input.data(), kNumFrames * kChannels, output); }) * kNumSamples / kNumFrames;
+
+	return maxError <= 1;
+}
+
+bool TestDownmix()
+{
+	double int16Ns = 0.0;
+	double floatNs = 0.0;
+	bool passed = CheckDownmix<int16_t>(AudioConverter::SF_S16, 32768.0, int16Ns);
+	passed = CheckDownmix<float>(AudioConverter::SF_FLOAT, 1.0, floatNs) && passed;
+	printf("AudioConverter 5.1 downmix: int16 %.3f ns/frame, float %.3f ns/frame including resampling ... %s\n", int16Ns, floatNs, passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+/**
+* Feeds one device's worth of buffers with the given clock skew and late callbacks to a ClockDriftEstimator
+* and returns the estimated skew in ppm after each of the checkpoints (in seconds).
+*/
+void SimulateClockDrift(double skewPpm, uint jitterMs, const uint* checkpoints, uint numCheckpoints, double* estimates)
+{
+	const uint kDeviceRate = 48000;
+	const uint kBufferFrames = 480;
+
+	// A generator of its own so the result doesn't depend on which tests ran before
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<double> jitterDistribution(0.0, static_cast<double>(jitterMs));
+
+	ClockDriftEstimator estimator(kDeviceRate);
+	const double actualRate = kDeviceRate * (1.0 + skewPpm / 1000000.0);
+
+	uint checkpoint = 0;
+	for (uint64_t buffer = 0; checkpoint < numCheckpoints; ++buffer)
+	{
+		// The buffer is complete once its last frame was captured, the callback runs some time after that
+		const double capturedMs = (buffer + 1) * kBufferFrames * 1000.0 / actualRate;
+		const uint64_t streamTimeMs = static_cast<uint64_t>(capturedMs + jitterDistribution(random));
+		estimator.AddSamples(streamTimeMs, kBufferFrames);
+
+		if (capturedMs >= checkpoints[checkpoint] * 1000.0)
+		{
+			estimates[checkpoint] = estimator.HasEstimate() ? estimator.GetSkewPpm() : 0.0;
+			++checkpoint;
+		}
+	}
+}
+
+bool TestClockDrift()
+{
+	bool passed = true;
+	const double skews[] = { 80.0, -120.0, 0.0 };
+	const uint checkpoints[] = { 20, 120, 600 };
+	for (uint s = 0; s < sizeof(skews) / sizeof(skews[0]); ++s)
+	{
+		double estimates[3];
+		SimulateClockDrift(skews[s], 8, checkpoints, 3, estimates);
+
+		// No estimate before 30 seconds. The jitter leaves an error of about 6 ppm RMS after two minutes and
+		// well under 1 ppm after ten, the limits are a few times that.
+		const bool skewPassed = estimates[0] == 0.0 && fabs(estimates[1] - skews[s]) <= 20.0 && fabs(estimates[2] - skews[s]) <= 3.0;
+		printf("ClockDriftEstimator %+.0f ppm with 8 ms jitter: %+.1f ppm after 2 min, %+.1f ppm after 10 min ... %s\n",
+			skews[s], estimates[1], estimates[2], skewPassed ? "passed" : "FAILED");
+		passed = passed && skewPassed;
+	}
+
+	return passed;
+}
+
+uint MsToFrames(uint ms)
+{
+	return static_cast<uint>(static_cast<uint64_t>(ms) * kOutputSampleRate / 1000);
+}
+
+/**
+* Submits a buffer of numFrames stereo frames counting up from firstValue to the aligner and returns what it passed on.
+*/
+std::vector<int16_t> SubmitAligned(AudioAligner& aligner, uint numFrames, uint64_t captureTimeMs, int16_t firstValue)
+{
+	std::vector<int16_t> samples(numFrames * 2);
+	for (uint i = 0; i < numFrames; ++i)
+	{
+		samples[i * 2] = static_cast<int16_t>(firstValue + i);
+		samples[i * 2 + 1] = static_cast<int16_t>(firstValue + i);
+	}
+
+	gSubmittedSamples.clear();
+	aligner.SubmitAudioSamples(samples.data(), static_cast<uint>(samples.size()), captureTimeMs);
+	return gSubmittedSamples;
+}
+
+bool CheckAligned(const char* name, const std::vector<int16_t>& submitted, uint silentFrames, uint numFrames, int16_t firstValue)
+{
+	bool passed = submitted.size() == (silentFrames + numFrames) * 2;
+	for (size_t i = 0; passed && i < submitted.size(); ++i)
+	{
+		const size_t frame = i / 2;
+		const int16_t expected = frame < silentFrames ? 0 : static_cast<int16_t>(firstValue + (frame - silentFrames));
+		passed = submitted[i] == expected;
+	}
+
+	if (!passed)
+	{
+		printf("AudioAligner %s: expected %u silent and %u audio frames, got %u frames ... FAILED\n",
+			name, silentFrames, numFrames, static_cast<uint>(submitted.size() / 2));
+	}
+	return passed;
+}
+
+bool TestAudioAligner()
+{
+	const uint kBufferFrames = 4410;	// 100 ms
+	bool passed = true;
+
+	// Contiguous audio and jitter inside the 20 ms tolerance pass straight through
+	AudioAligner aligner;
+	passed = CheckAligned("contiguous", SubmitAligned(aligner, kBufferFrames, 0, 1), 0, kBufferFrames, 1) && passed;
+	passed = CheckAligned("late jitter", SubmitAligned(aligner, kBufferFrames, 100 + 19, 2), 0, kBufferFrames, 2) && passed;
+	passed = CheckAligned("early jitter", SubmitAligned(aligner, kBufferFrames, 200 - 19, 3), 0, kBufferFrames, 3) && passed;
+
+	// A 50 ms gap is filled with silence
+	passed = CheckAligned("gap", SubmitAligned(aligner, kBufferFrames, 300 + 50, 4), MsToFrames(50), kBufferFrames, 4) && passed;
+
+	// A buffer starting 40 ms early loses its first 40 ms, one that lies entirely in the past is dropped
+	passed = CheckAligned("overlap", SubmitAligned(aligner, kBufferFrames, 450 - 40, 5), 0, kBufferFrames - MsToFrames(40),
+		static_cast<int16_t>(5 + MsToFrames(40))) && passed;
+	passed = CheckAligned("stale", SubmitAligned(aligner, kBufferFrames, 300, 6), 0, 0, 6) && passed;
+	passed = passed && aligner.GetInsertedFrames() == MsToFrames(50) && aligner.GetTrimmedFrames() == MsToFrames(40) + kBufferFrames;
+
+	// Jumps of more than 10 seconds in either direction are bogus timestamps, the audio is submitted unchanged
+	AudioAligner bogus;
+	passed = CheckAligned("9.9 s ahead", SubmitAligned(bogus, kBufferFrames, 9900, 7), MsToFrames(9900), kBufferFrames, 7) && passed;
+	passed = CheckAligned("10.1 s ahead", SubmitAligned(bogus, kBufferFrames, 10000 + 10100, 8), 0, kBufferFrames, 8) && passed;
+	for (uint i = 0; i < 10; ++i)
+	{
+		SubmitAligned(bogus, kBufferFrames, 10100 + 100 * i, 9);
+	}
+	passed = CheckAligned("10.1 s behind", SubmitAligned(bogus, kBufferFrames, 11100 - 10100, 10), 0, kBufferFrames, 10) && passed;
+	passed = CheckAligned("9.9 s behind", SubmitAligned(bogus, kBufferFrames, 11200 - 9900, 11), 0, 0, 11) && passed;
+
+	printf("AudioAligner: tolerance, gap fill, overlap trim and the 10 second bound ... %s\n", passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+template <typename SampleType>
+bool CheckLevels(const char* name, const std::vector<SampleType>& samples, double fullScale)
+{
+	// One interval per buffer, fed in uneven pieces so the SIMD body and scalar tail both run
+	const uint numSamples = static_cast<uint>(samples.size());
+	AudioLevelMeter meter(numSamples, 1, 1000);
+	const uint pieces[] = { 1, 7, 37, 4096 };
+	for (uint offset = 0, p = 0; offset < numSamples; ++p)
+	{
+		const uint count = pieces[p % 4] < numSamples - offset ? pieces[p % 4] : numSamples - offset;
+		meter.Process(samples.data() + offset, count);
+		offset += count;
+	}
+
+	AudioLevelMeter::Levels actual;
+	const bool published = meter.PollLevels(actual);
+	const AudioLevelMeter::Levels expected = MeasureReference(samples.data(), samples.size(), fullScale);
+
+	const bool passed = published && actual.peak == expected.peak && fabs(actual.rms - expected.rms) <= 1e-4 * expected.rms + 1e-9 &&
+		actual.clippedSamples == expected.clippedSamples;
+	if (!passed)
+	{
+		printf("AudioLevelMeter %s: peak %.6f/%.6f, rms %.6f/%.6f, clipped %u/%u ... FAILED\n", name, actual.peak, expected.peak,
+			actual.rms, expected.rms, actual.clippedSamples, expected.clippedSamples);
+	}
+	return passed;
+}
+
+bool TestLevelMeter()
+{
+	bool passed = true;
+
+	// Full scale negative samples square to 2^31 which only fits the SIMD sums as unsigned
+	std::vector<int16_t> int16Samples(kNumSamples);
+	std::uniform_int_distribution<int> sampleDistribution(INT16_MIN, INT16_MAX);
+	for (size_t i = 0; i < kNumSamples; ++i)
+	{
+		int16Samples[i] = static_cast<int16_t>(i % 97 == 0 ? INT16_MAX : (i % 89 == 0 ? INT16_MIN : sampleDistribution(gRandom)));
+	}
+	passed = CheckLevels("int16 random", int16Samples, 32768.0) && passed;
+	passed = CheckLevels("int16 full scale", std::vector<int16_t>(kNumSamples, INT16_MIN), 32768.0) && passed;
+	passed = CheckLevels("int16 silence", std::vector<int16_t>(kNumSamples, 0), 32768.0) && passed;
+
+	std::vector<float> floatSamples(kNumSamples);
+	std::uniform_real_distribution<float> floatDistribution(-1.1f, 1.1f);
+	for (size_t i = 0; i < kNumSamples; ++i)
+	{
+		floatSamples[i] = floatDistribution(gRandom);
+	}
+	passed = CheckLevels("float random", floatSamples, 1.0) && passed;
+	passed = CheckLevels("float full scale", std::vector<float>(kNumSamples, -1.0f), 1.0) && passed;
+
+	AudioLevelMeter meter(kOutputSampleRate, 2, 100);
+	const double int16Ns = TimeNsPerSample([&]() { meter.Process(int16Samples.data(), kNumSamples); });
+	const double floatNs = TimeNsPerSample([&]() { meter.Process(floatSamples.data(), kNumSamples); });
+
+	printf("AudioLevelMeter: int16 %.3f ns/sample, float %.3f ns/sample ... %s\n", int16Ns, floatNs, passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	bool passed = true;
+	passed = TestMixInt16() && passed;
+	passed = TestMixFloat() && passed;
+	passed = TestConverter() && passed;
+	passed = TestDownmix() && passed;
+	passed = TestLevelMeter() && passed;
+	passed = TestClockDrift() && passed;
+	passed = TestAudioAligner() && passed;
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,389 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "twitchsdk.h"
+#include "passthroughplugin.h"
+
+namespace
+{
+	const uint8_t kNalTypeIdrSlice = 5;
+	const uint8_t kNalTypeSps = 7;
+
+	/**
+	* Reads the fields of a NAL unit payload, skipping the emulation prevention bytes.
+	*/
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* data, size_t size)
+		: mData(data)
+		, mSize(size)
+		, mByte(0)
+		, mBit(0)
+		, mZeros(0)
+		, mOverrun(false)
+		{
+		}
+
+		bool Overrun() const { return mOverrun; }
+
+		uint ReadBits(uint count)
+		{
+			uint value = 0;
+			for (uint i = 0; i < count; ++i)
+			{
+				value = (value << 1) | ReadBit();
+			}
+			return value;
+		}
+
+		// Exp-Golomb coded unsigned value
+		uint ReadUe()
+		{
+			uint leadingZeros = 0;
+			while (ReadBit() == 0 && !mOverrun)
+			{
+				if (++leadingZeros > 31)
+				{
+					mOverrun = true;
+					return 0;
+				}
+			}
+			return ((1u << leadingZeros) - 1) + ReadBits(leadingZeros);
+		}
+
+		// Exp-Golomb coded signed value
+		int ReadSe()
+		{
+			uint value = ReadUe();
+			return (value & 1) ? static_cast<int>((value + 1) / 2) : -static_cast<int>(value / 2);
+		}
+
+	private:
+		uint ReadBit()
+		{
+			if (mBit == 0)
+			{
+				// 00 00 03 is an escaped 00 00
+				if (mZeros >= 2 && mByte < mSize && mData[mByte] == 3)
+				{
+					++mByte;
+					mZeros = 0;
+				}
+				if (mByte >= mSize)
+				{
+					mOverrun = true;
+					return 0;
+				}
+				mZeros = mData[mByte] == 0 ? mZeros + 1 : 0;
+			}
+
+			uint bit = (mData[mByte] >> (7 - mBit)) & 1;
+			if (++mBit == 8)
+			{
+				mBit = 0;
+				++mByte;
+			}
+			return bit;
+		}
+
+		const uint8_t* mData;
+		size_t mSize;
+		size_t mByte;
+		uint mBit;
+		uint mZeros;
+		bool mOverrun;
+	};
+}
+
+//--------------------------------------------------------------------------
+// Finds the next Annex B NAL unit at or after offset, which may be empty. Returns false when there is none.
+static bool FindNalUnit(const uint8_t* data, size_t size, size_t& offset, const uint8_t*& nal, size_t& nalSize)
+{
+	size_t start = SIZE_MAX;
+	for (size_t i = offset; i + 3 <= size; ++i)
+	{
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+		{
+			start = i + 3;
+			break;
+		}
+	}
+	if (start == SIZE_MAX)
+	{
+		return false;
+	}
+
+	size_t end = size;
+	for (size_t i = start; i + 3 <= size; ++i)
+	{
+		if (data[i] == 0 && data[i + 1] == 0 && (data[i + 2] == 1 || data[i + 2] == 0))
+		{
+			end = i;
+			break;
+		}
+	}
+
+	nal = data + start;
+	nalSize = end - start;
+	offset = end;
+	return true;
+}
+
+
+//--------------------------------------------------------------------------
+PassthroughPlugin::PassthroughPlugin()
+: mNextSequenceNumber(0)
+, mExpectedSequenceNumber(0)
+, mWaitingForKeyFrame(true)
+, mSpsParsed(false)
+, mSeparateColourPlane(false)
+, mFrameMbsOnly(true)
+, mLog2MaxFrameNum(0)
+, mLastIdrPicId(-1)
+{
+
+}
+
+//--------------------------------------------------------------------------
+bool PassthroughPlugin::ParseSps(const uint8_t* data, size_t size)
+{
+	size_t offset = 0;
+	const uint8_t* nal = nullptr;
+	size_t nalSize = 0;
+	if (!FindNalUnit(data, size, offset, nal, nalSize) || nalSize == 0 || (nal[0] & 0x1F) != kNalTypeSps)
+	{
+		return false;
+	}
+
+	BitReader reader(nal + 1, nalSize - 1);
+	const uint profileIdc = reader.ReadBits(8);
+	reader.ReadBits(16);	// constraint flags and level_idc
+	reader.ReadUe();		// seq_parameter_set_id
+
+	mSeparateColourPlane = false;
+	if (profileIdc == 100 || profileIdc == 110 || profileIdc == 122 || profileIdc == 244 || profileIdc == 44 ||
+		profileIdc == 83 || profileIdc == 86 || profileIdc == 118 || profileIdc == 128 || profileIdc == 138 ||
+		profileIdc == 139 || profileIdc == 134 || profileIdc == 135)
+	{
+		const uint chromaFormatIdc = reader.ReadUe();
+		if (chromaFormatIdc == 3)
+		{
+			mSeparateColourPlane = reader.ReadBits(1) != 0;
+		}
+		reader.ReadUe();		// bit_depth_luma_minus8
+		reader.ReadUe();		// bit_depth_chroma_minus8
+		reader.ReadBits(1);		// qpprime_y_zero_transform_bypass_flag
+
+		// seq_scaling_matrix_present_flag
+		if (reader.ReadBits(1))
+		{
+			const uint numLists = chromaFormatIdc != 3 ? 8 : 12;
+			for (uint i = 0; i < numLists && !reader.Overrun(); ++i)
+			{
+				if (!reader.ReadBits(1))
+				{
+					continue;
+				}
+
+				const uint listSize = i < 6 ? 16 : 64;
+				int lastScale = 8;
+				int nextScale = 8;
+				for (uint j = 0; j < listSize && nextScale != 0 && !reader.Overrun(); ++j)
+				{
+					nextScale = (lastScale + reader.ReadSe() + 256) % 256;
+					lastScale = nextScale == 0 ? lastScale : nextScale;
+				}
+			}
+		}
+	}
+
+	mLog2MaxFrameNum = reader.ReadUe() + 4;
+
+	const uint picOrderCntType = reader.ReadUe();
+	if (picOrderCntType == 0)
+	{
+		reader.ReadUe();		// log2_max_pic_order_cnt_lsb_minus4
+	}
+	else if (picOrderCntType == 1)
+	{
+		reader.ReadBits(1);		// delta_pic_order_always_zero_flag
+		reader.ReadSe();		// offset_for_non_ref_pic
+		reader.ReadSe();		// offset_for_top_to_bottom_field
+		const uint numRefFrames = reader.ReadUe();
+		for (uint i = 0; i < numRefFrames && !reader.Overrun(); ++i)
+		{
+			reader.ReadSe();
+		}
+	}
+
+	reader.ReadUe();		// max_num_ref_frames
+	reader.ReadBits(1);		// gaps_in_frame_num_value_allowed_flag
+	reader.ReadUe();		// pic_width_in_mbs_minus1
+	reader.ReadUe();		// pic_height_in_map_units_minus1
+	mFrameMbsOnly = reader.ReadBits(1) != 0;
+
+	return !reader.Overrun() && mLog2MaxFrameNum <= 16;
+}
+
+//--------------------------------------------------------------------------
+int PassthroughPlugin::GetIdrPicId(const EncodedFrame* frame) const
+{
+	if (!mSpsParsed)
+	{
+		return -1;
+	}
+
+	size_t offset = 0;
+	const uint8_t* nal = nullptr;
+	size_t nalSize = 0;
+	while (FindNalUnit(frame->nalData, frame->size, offset, nal, nalSize))
+	{
+		if (nalSize == 0 || (nal[0] & 0x1F) != kNalTypeIdrSlice)
+		{
+			continue;
+		}
+
+		BitReader reader(nal + 1, nalSize - 1);
+		reader.ReadUe();		// first_mb_in_slice
+		reader.ReadUe();		// slice_type
+		reader.ReadUe();		// pic_parameter_set_id
+		if (mSeparateColourPlane)
+		{
+			reader.ReadBits(2);	// colour_plane_id
+		}
+		reader.ReadBits(mLog2MaxFrameNum);	// frame_num
+		if (!mFrameMbsOnly && reader.ReadBits(1))
+		{
+			reader.ReadBits(1);	// bottom_field_flag
+		}
+
+		const uint idrPicId = reader.ReadUe();
+		return reader.Overrun() ? -1 : static_cast<int>(idrPicId);
+	}
+
+	return -1;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode PassthroughPlugin::SetSpsPps(const uint8_t* sps, size_t spsSize, const uint8_t* pps, size_t ppsSize)
+{
+	if (sps == nullptr || spsSize == 0 || pps == nullptr || ppsSize == 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	mSps.assign(sps, sps + spsSize);
+	mPps.assign(pps, pps + ppsSize);
+
+	// Needed to read idr_pic_id from the slice headers. Without it consecutive IDR frames can't be checked.
+	mSpsParsed = ParseSps(sps, spsSize);
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode PassthroughPlugin::SubmitFrame(EncodedFrame* frame, TTV_BufferUnlockCallback callback, void* userData)
+{
+	if (frame == nullptr || frame->nalData == nullptr || frame->size == 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	// Always consume a sequence number so EncodeFrame notices frames the SDK refused or dropped
+	frame->magic = kFrameMagic;
+	frame->sequenceNumber = mNextSequenceNumber++;
+
+	return TTV_SubmitVideoFrame(reinterpret_cast<const uint8_t*>(frame), callback, userData);
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode PassthroughPlugin::Start(const TTV_VideoParams* videoParams)
+{
+	assert(videoParams);
+	UNUSED(videoParams);
+
+	if (mSps.empty() || mPps.empty())
+	{
+		return TTV_EC_NO_SPSPPS;
+	}
+
+	// The stream has to begin with an IDR frame
+	mExpectedSequenceNumber = mNextSequenceNumber;
+	mWaitingForKeyFrame = true;
+	mLastIdrPicId = -1;
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode PassthroughPlugin::GetSpsPps(ITTVBuffer* outSps, ITTVBuffer* outPps)
+{
+	if (mSps.empty() || mPps.empty())
+	{
+		return TTV_EC_NO_SPSPPS;
+	}
+
+	outSps->Append(mSps.data(), mSps.size());
+	outPps->Append(mPps.data(), mPps.size());
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode PassthroughPlugin::EncodeFrame(const EncodeInput& input, EncodeOutput& output)
+{
+	// Nothing is buffered so there is nothing to flush on shutdown
+	if (input.source == nullptr)
+	{
+		return TTV_WRN_NOMOREDATA;
+	}
+
+	// Skip anything that wasn't submitted through SubmitFrame (e.g. the SDK's pause frames or a
+	// frame passed to TTV_SubmitVideoFrame directly)
+	const EncodedFrame* frame = reinterpret_cast<const EncodedFrame*>(input.source);
+	if (frame->magic != kFrameMagic)
+	{
+		return TTV_WRN_NOMOREDATA;
+	}
+
+	int32_t delta = static_cast<int32_t>(frame->sequenceNumber - mExpectedSequenceNumber);
+	if (delta < 0)
+	{
+		// The SDK duplicated a frame to keep up the target frame rate. Sending the same
+		// encoded frame twice would corrupt the stream so we skip it.
+		return TTV_WRN_NOMOREDATA;
+	}
+	else if (delta > 0)
+	{
+		// Frames were dropped, the following inter frames can't be decoded
+		mWaitingForKeyFrame = true;
+	}
+	mExpectedSequenceNumber = frame->sequenceNumber + 1;
+
+	if (mWaitingForKeyFrame)
+	{
+		if (!frame->isKeyFrame)
+		{
+			return TTV_WRN_NOMOREDATA;
+		}
+	}
+
+	// Consecutive IDR frames must have different idr_pic_id values. When frames in between were dropped
+	// (e.g. a replayed pair of IDR frames) wait for one that differs from the IDR frame sent last.
+	const int idrPicId = frame->isKeyFrame ? GetIdrPicId(frame) : -1;
+	if (idrPicId >= 0 && idrPicId == mLastIdrPicId)
+	{
+		mWaitingForKeyFrame = true;
+		return TTV_WRN_NOMOREDATA;
+	}
+	mLastIdrPicId = idrPicId;
+	mWaitingForKeyFrame = false;
+
+	output.frameTimeStamp = input.timeStamp;
+	output.isKeyFrame = frame->isKeyFrame;
+	output.frameData->Append(const_cast<uint8_t*>(frame->nalData), frame->size);
+
+	return TTV_EC_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "twitchinterfaces.h"
+
+#include <atomic>
+#include <vector>
+
+/**
+* PassthroughPlugin - Streams h264 data that was already encoded by the client
+* (e.g. by a hardware encoder used for a replay system). No YUV conversion or
+* encoding is done, the SDK only muxes the frames into FLV and sends them.
+*
+* Submit each encoded frame with SubmitFrame() instead of calling TTV_SubmitVideoFrame
+* yourself. Frames must be Annex B (start code prefixed) NAL units in decode order
+* without reordering (no b-frames) since the SDK timestamps frames as they are submitted.
+*
+* TTV_PauseVideo is not supported with this plugin. The pause frames the SDK generates aren't
+* encoded frames and are skipped, so the stream simply has no video while paused.
+*/
+class PassthroughPlugin: public ITTVPluginVideoEncoder
+{
+public:
+	/**
+	* Describes one access unit of encoded video. The struct and the data it points to
+	* must stay valid until the unlock callback passed to SubmitFrame is called.
+	*/
+	struct EncodedFrame
+	{
+		uint32_t magic;				/* For internal use - set by SubmitFrame */
+		const uint8_t* nalData;		/* The Annex B NAL units of the frame */
+		size_t size;				/* Size of nalData in bytes */
+		bool isKeyFrame;			/* The frame is an IDR frame */
+		uint32_t sequenceNumber;	/* For internal use - set by SubmitFrame */
+	};
+
+	PassthroughPlugin();
+
+	/**
+	* SetSpsPps - Set the sequence and picture parameter sets of the stream. Must be called
+	* before TTV_Start and the values must match the frames that will be submitted. Each is a
+	* single NAL unit including its Annex B start code (00 00 00 01), the same format
+	* X264Plugin::GetSpsPps passes to the SDK.
+	*/
+	TTV_ErrorCode SetSpsPps(const uint8_t* sps, size_t spsSize, const uint8_t* pps, size_t ppsSize);
+
+	/**
+	* SubmitFrame - Submit an encoded frame to the stream.
+	* @param[in] frame - The frame to submit. It is passed back as the buffer in the callback.
+	* @param[in] callback - The callback function to be called when the frame is no longer needed
+	* @param[in] userData - Optional pointer to be passed through to the callback function
+	* @return - The result of TTV_SubmitVideoFrame
+	*/
+	TTV_ErrorCode SubmitFrame(EncodedFrame* frame, TTV_BufferUnlockCallback callback, void* userData);
+
+	/**
+	* NeedsKeyFrame - Returns true while frames are being discarded until the next keyframe. This is
+	* the case from construction and after each Start until the first IDR frame arrives (the stream
+	* must begin with an IDR frame), and again whenever a submitted frame was dropped by the SDK.
+	* An IDR frame with the same idr_pic_id as an IDR frame sent right before it is discarded too,
+	* since consecutive IDR frames must differ. The client should force its encoder to emit an IDR
+	* frame when this returns true.
+	*/
+	bool NeedsKeyFrame() const { return mWaitingForKeyFrame; }
+
+	TTV_ErrorCode Start(const TTV_VideoParams* videoParams) override;
+	TTV_ErrorCode GetSpsPps(ITTVBuffer* outSps, ITTVBuffer* outPps) override;
+	TTV_ErrorCode EncodeFrame(const EncodeInput& input, EncodeOutput& output) override;
+
+	TTV_YUVFormat GetRequiredYUVFormat() const override { return TTV_YUV_NONE; }
+private:
+	bool ParseSps(const uint8_t* data, size_t size);
+	int GetIdrPicId(const EncodedFrame* frame) const;
+
+	static const uint32_t kFrameMagic = 0x46505450;	// "PTPF"
+
+	std::vector<uint8_t> mSps;
+	std::vector<uint8_t> mPps;
+	std::atomic<uint32_t> mNextSequenceNumber;
+	uint32_t mExpectedSequenceNumber;
+	std::atomic<bool> mWaitingForKeyFrame;
+
+	// From the SPS, needed to find idr_pic_id in the slice header
+	bool mSpsParsed;
+	bool mSeparateColourPlane;
+	bool mFrameMbsOnly;
+	uint mLog2MaxFrameNum;
+	int mLastIdrPicId;			// idr_pic_id of the last frame sent if it was an IDR frame, -1 otherwise
+};
@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cstdint>
+
+#include "twitchsdk.h"
+#include "stillimagesource.h"
+
+
+//--------------------------------------------------------------------------
+StillImageSource::StillImageSource(PassthroughPlugin& plugin, uint intervalMs)
+: mPlugin(plugin)
+, mNextSubmitTimeMs(0)
+, mIntervalMs(intervalMs)
+, mNextFrame(0)
+{
+	for (uint i = 0; i < kNumSlots; ++i)
+	{
+		mSlots[i].inUse = false;
+	}
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode StillImageSource::SetFrames(const uint8_t* firstIdr, size_t firstSize, const uint8_t* secondIdr, size_t secondSize)
+{
+	if (firstIdr == nullptr || firstSize == 0 || secondIdr == nullptr || secondSize == 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	mFrames[0].assign(firstIdr, firstIdr + firstSize);
+	mFrames[1].assign(secondIdr, secondIdr + secondSize);
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode StillImageSource::Update(uint64_t timeMs)
+{
+	if (mFrames[0].empty() || timeMs < mNextSubmitTimeMs)
+	{
+		return TTV_EC_SUCCESS;
+	}
+
+	// The SDK holds on to submitted frames for a while, find a descriptor it has released
+	Slot* slot = nullptr;
+	for (uint i = 0; i < kNumSlots; ++i)
+	{
+		if (!mSlots[i].inUse)
+		{
+			slot = &mSlots[i];
+			break;
+		}
+	}
+	if (slot == nullptr)
+	{
+		return TTV_EC_SUCCESS;
+	}
+
+	const std::vector<uint8_t>& data = mFrames[mNextFrame];
+	slot->frame.nalData = data.data();
+	slot->frame.size = data.size();
+	slot->frame.isKeyFrame = true;
+	slot->inUse = true;
+
+	TTV_ErrorCode ret = mPlugin.SubmitFrame(&slot->frame, FrameUnlockCallback, slot);
+	if (TTV_FAILED(ret))
+	{
+		slot->inUse = false;
+		return ret;
+	}
+
+	mNextFrame ^= 1;
+	mNextSubmitTimeMs = timeMs + mIntervalMs;
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+void StillImageSource::FrameUnlockCallback(const uint8_t* /*buffer*/, void* userData)
+{
+	Slot* slot = static_cast<Slot*>(userData);
+	assert(slot);
+
+	slot->inUse = false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "passthroughplugin.h"
+
+#include <atomic>
+#include <vector>
+
+/**
+* StillImageSource - Video for audio-only broadcasts (radio style streams, lobbies) at almost no CPU cost.
+*
+* Encode the still image once, ahead of time (e.g. offline with x264 and shipped as an asset, or once
+* at startup with your own encoder), as two consecutive IDR frames. Consecutive IDR frames must have
+* different idr_pic_id values which is why two are needed; x264 alternates them on its own. The frames
+* are replayed through a PassthroughPlugin at a low rate so the SDK does no conversion or encoding at
+* all and only the audio path does real work. If the SDK drops a frame the plugin skips the following
+* frame if it has the same idr_pic_id as the last one sent, so the stream stays conforming.
+*
+* Call PassthroughPlugin::SetSpsPps with the SPS and PPS the still was encoded with before TTV_Start,
+* otherwise the plugin fails to start with TTV_EC_NO_SPSPPS. Set up the broadcast with
+* TTV_VID_ENC_PLUGIN, the PassthroughPlugin as the encoderPlugin, the resolution the still was
+* encoded at and TTV_MIN_FPS, then call Update regularly (e.g. once per game frame).
+*/
+class StillImageSource
+{
+public:
+	/**
+	* @param[in] plugin - The plugin the broadcast was started with. Must outlive this object.
+	* @param[in] intervalMs - Time between submitted frames. Lower rates use less bandwidth but
+	*                         players take longer to show the image after joining.
+	*/
+	StillImageSource(PassthroughPlugin& plugin, uint intervalMs = 1000);
+
+	/**
+	* SetFrames - Set the two encoded IDR frames (Annex B) of the still image. The data is copied.
+	*/
+	TTV_ErrorCode SetFrames(const uint8_t* firstIdr, size_t firstSize, const uint8_t* secondIdr, size_t secondSize);
+
+	/**
+	* Update - Submits the next frame if the interval has elapsed.
+	* @param[in] timeMs - A monotonic time in milliseconds
+	* @return - TTV_EC_SUCCESS if function succeeds; error code from TTV_SubmitVideoFrame otherwise
+	*/
+	TTV_ErrorCode Update(uint64_t timeMs);
+
+private:
+	static const uint kNumSlots = 4;
+
+	struct Slot
+	{
+		PassthroughPlugin::EncodedFrame frame;
+		std::atomic<bool> inUse;
+	};
+
+	static void FrameUnlockCallback(const uint8_t* buffer, void* userData);
+
+	PassthroughPlugin& mPlugin;
+	std::vector<uint8_t> mFrames[2];
+	Slot mSlots[kNumSlots];
+	uint64_t mNextSubmitTimeMs;
+	uint mIntervalMs;
+	uint mNextFrame;
+};
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <climits>
 #include <cstdint>
 #include <cstring>
 
@@ -43,6 +44,8 @@ X264Plugin::X264Plugin()
 : mOutputWidth(0)
 , mOutputHeight(0)
 , mX264Encoder(0)
+, mKeyFrameRequested(false)
+, mVbvBufferMs(2000)
 {
 
 }
@@ -72,7 +75,12 @@ TTV_ErrorCode X264Plugin::Start(const TTV_VideoParams* videoParams)
 	// TODO - these params should be probably passed in
 	param.analyse.i_subpel_refine = 7;
 	param.rc.i_vbv_max_bitrate = videoParams->maxKbps;
-	param.rc.i_vbv_buffer_size = param.rc.i_vbv_max_bitrate * 2;
+	const uint64_t vbvBufferSize = static_cast<uint64_t>(videoParams->maxKbps) * mVbvBufferMs / 1000;
+	param.rc.i_vbv_buffer_size = static_cast<int>(vbvBufferSize > INT_MAX ? INT_MAX : vbvBufferSize);
+	if (param.rc.i_vbv_buffer_size <= 0)
+	{
+		param.rc.i_vbv_buffer_size = 1;
+	}
 	param.i_keyint_min = 90;
 	param.i_keyint_max = static_cast<int>(videoParams->targetFps) * 5;
 
@@ -143,6 +151,12 @@ TTV_ErrorCode X264Plugin::EncodeFrame(const EncodeInput& input, EncodeOutput& ou
 		
 		// Set the frame PTS for VFR
 		x264InputFrame.i_pts = input.timeStamp;
+
+		// Let x264 pick the frame type unless the client asked for a keyframe
+		if (mKeyFrameRequested.exchange(false))
+		{
+			x264InputFrame.i_type = X264_TYPE_IDR;
+		}
 		pInputFrame = &x264InputFrame;
 	}
 	else
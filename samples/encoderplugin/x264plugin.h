@@ -1,5 +1,7 @@
 #include "twitchinterfaces.h"
 
+#include <atomic>
+
 struct x264_t;
 
 class X264Plugin: public ITTVPluginVideoEncoder
@@ -7,6 +9,21 @@ class X264Plugin: public ITTVPluginVideoEncoder
 public:
 	X264Plugin();
 
+	/**
+	* RequestKeyFrame - Forces the next frame passed to EncodeFrame to be encoded as an IDR
+	* frame (e.g. after a scene cut or when resuming from TTV_PauseVideo) instead of waiting
+	* for the keyframe interval. Can be called from any thread.
+	*/
+	void RequestKeyFrame() { mKeyFrameRequested = true; }
+
+	/**
+	* SetVbvBufferMs - Sets the size of the rate control buffer in milliseconds at maxKbps. This
+	* bounds how far above the average a single frame can go, so a smaller buffer spreads keyframe
+	* bits over the following frames and avoids sending keyframes as large bursts that bloat the
+	* uplink queue. Smaller values lower keyframe quality. Defaults to 2000. Call before TTV_Start.
+	*/
+	void SetVbvBufferMs(uint bufferMs) { mVbvBufferMs = bufferMs; }
+
 	TTV_ErrorCode Start(const TTV_VideoParams* videoParams) override;
 	TTV_ErrorCode GetSpsPps(ITTVBuffer* outSps, ITTVBuffer* outPps) override;
 	TTV_ErrorCode EncodeFrame(const EncodeInput& input, EncodeOutput& output) override;
@@ -16,5 +33,7 @@ private:
 	uint mOutputWidth;
 	uint mOutputHeight;
 	x264_t* mX264Encoder;
+	std::atomic<bool> mKeyFrameRequested;
+	uint mVbvBufferMs;
 
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define MOTION_ANALYZER_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#	include <arm_neon.h>
+#	define MOTION_ANALYZER_NEON 1
+#endif
+
+#include "twitchsdk.h"
+#include "motionanalyzer.h"
+
+namespace
+{
+	const uint kSubsampleStep = 4;				// Only every 4th pixel of every 4th row is looked at
+	const float kHighMotionSad = 20.0f;			// Mean absolute luma difference between consecutive frames considered to be fast motion
+	const float kSmoothing = 0.05f;				// Weight of the newest frame in the running motion estimate
+	const float kMinBitsPerPixel = 0.075f;		// Static content
+	const float kDefaultBitsPerPixel = 0.1f;	// Average motion
+	const float kMaxBitsPerPixel = 0.2f;		// Fast motion with lots of scene changes
+}
+
+//--------------------------------------------------------------------------
+static uint64_t SumOfAbsoluteDifferences(const uint8_t* a, const uint8_t* b, size_t count)
+{
+	uint64_t sad = 0;
+	size_t i = 0;
+
+#if MOTION_ANALYZER_SSE2
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	sad = static_cast<uint32_t>(_mm_cvtsi128_si32(acc)) + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif MOTION_ANALYZER_NEON
+	uint32x4_t acc = vdupq_n_u32(0);
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+		acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+	}
+	uint64x2_t sum = vpaddlq_u32(acc);
+	sad = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+#endif
+
+	for (; i < count; ++i)
+	{
+		sad += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	}
+
+	return sad;
+}
+
+//--------------------------------------------------------------------------
+static void ExtractSubsampledLuma(const uint8_t* frameBuffer, uint width, uint height, TTV_PixelFormat pixelFormat, uint8_t* luma)
+{
+	// The pixel format values encode the byte offset of each channel
+	const uint r = (pixelFormat >> 8) & 0xFF;
+	const uint g = (pixelFormat >> 16) & 0xFF;
+	const uint b = (pixelFormat >> 24) & 0xFF;
+
+	for (uint y = 0; y < height; y += kSubsampleStep)
+	{
+		const uint8_t* row = frameBuffer + static_cast<size_t>(y) * width * 4;
+		for (uint x = 0; x < width; x += kSubsampleStep)
+		{
+			const uint8_t* pixel = row + x * 4;
+			*luma++ = static_cast<uint8_t>((2 * pixel[r] + 5 * pixel[g] + pixel[b]) >> 3);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------
+MotionAnalyzer::MotionAnalyzer()
+: mLumaWidth(0)
+, mLumaHeight(0)
+, mCurrent(0)
+, mFramesAnalyzed(0)
+, mMotionFactor(0.0f)
+{
+
+}
+
+//--------------------------------------------------------------------------
+void MotionAnalyzer::Reset()
+{
+	mLuma[0].clear();
+	mLuma[1].clear();
+	mLumaWidth = 0;
+	mLumaHeight = 0;
+	mCurrent = 0;
+	mFramesAnalyzed = 0;
+	mMotionFactor = 0.0f;
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode MotionAnalyzer::AnalyzeFrame(const uint8_t* frameBuffer, uint width, uint height, TTV_PixelFormat pixelFormat, uint frameInterval)
+{
+	if (frameBuffer == nullptr || width == 0 || height == 0 || frameInterval == 0)
+	{
+		return TTV_EC_INVALID_ARG;
+	}
+
+	const uint lumaWidth = (width + kSubsampleStep - 1) / kSubsampleStep;
+	const uint lumaHeight = (height + kSubsampleStep - 1) / kSubsampleStep;
+	if (lumaWidth != mLumaWidth || lumaHeight != mLumaHeight)
+	{
+		Reset();
+		mLumaWidth = lumaWidth;
+		mLumaHeight = lumaHeight;
+		mLuma[0].resize(lumaWidth * lumaHeight);
+		mLuma[1].resize(lumaWidth * lumaHeight);
+	}
+
+	mCurrent ^= 1;
+	ExtractSubsampledLuma(frameBuffer, width, height, pixelFormat, mLuma[mCurrent].data());
+
+	if (++mFramesAnalyzed < 2)
+	{
+		return TTV_EC_SUCCESS;
+	}
+
+	const size_t count = mLuma[mCurrent].size();
+	const uint64_t sad = SumOfAbsoluteDifferences(mLuma[mCurrent].data(), mLuma[mCurrent ^ 1].data(), count);
+
+	// kHighMotionSad is per frame, scale it to the distance between the analyzed frames
+	float motion = static_cast<float>(sad) / static_cast<float>(count) / (kHighMotionSad * frameInterval);
+	if (motion > 1.0f)
+	{
+		motion = 1.0f;
+	}
+
+	// Smooth out single scene cuts so the recommendation doesn't jump around
+	mMotionFactor = mFramesAnalyzed == 2 ? motion : mMotionFactor + kSmoothing * (motion - mMotionFactor);
+
+	return TTV_EC_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+float MotionAnalyzer::GetBitsPerPixel() const
+{
+	if (mFramesAnalyzed < 2)
+	{
+		return kDefaultBitsPerPixel;
+	}
+
+	return kMinBitsPerPixel + mMotionFactor * (kMaxBitsPerPixel - kMinBitsPerPixel);
+}
+
+//--------------------------------------------------------------------------
+TTV_ErrorCode MotionAnalyzer::GetRecommendedResolution(uint maxKbps, uint frameRate, float aspectRatio, uint* width, uint* height) const
+{
+	return TTV_GetMaxResolution(maxKbps, frameRate, GetBitsPerPixel(), aspectRatio, width, height);
+}
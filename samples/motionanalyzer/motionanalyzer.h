@@ -0,0 +1,71 @@
+#pragma once
+
+#include "twitchsdktypes.h"
+#include "twitchcore/types/errortypes.h"
+
+#include <vector>
+
+/**
+* MotionAnalyzer - Estimates how much motion there is in the frames being broadcast so that
+* TTV_GetMaxResolution can be called with a bits per pixel value that matches the content
+* instead of a guessed constant.
+*
+* Pass some of the frames you submit to TTV_SubmitVideoFrame to AnalyzeFrame (every few frames
+* is enough). Each frame is reduced to a subsampled luma image and compared with the previous one
+* using SIMD sum of absolute differences, so the cost is a small fraction of a YUV conversion.
+*
+* The difference is divided by the number of submitted frames between the two analyzed frames so
+* the estimate is per frame whatever the cadence. This assumes motion adds up roughly linearly over
+* a few frames, so keep the cadence short (up to about 4 frames) and steady.
+*/
+class MotionAnalyzer
+{
+public:
+	MotionAnalyzer();
+
+	/**
+	* Reset - Forget all previously analyzed frames (e.g. when the output resolution changes)
+	*/
+	void Reset();
+
+	/**
+	* AnalyzeFrame - Compare the frame with the previously analyzed one and update the motion estimate.
+	* @param[in] frameBuffer - The frame in the same layout as passed to TTV_SubmitVideoFrame
+	* @param[in] width - Width of the frame in pixels
+	* @param[in] height - Height of the frame in pixels
+	* @param[in] pixelFormat - Pixel format of the frame
+	* @param[in] frameInterval - Number of frames submitted since the previously analyzed frame, 1 if every frame is analyzed
+	* @return - TTV_EC_SUCCESS if function succeeds; error code otherwise
+	*/
+	TTV_ErrorCode AnalyzeFrame(const uint8_t* frameBuffer, uint width, uint height, TTV_PixelFormat pixelFormat, uint frameInterval = 1);
+
+	/**
+	* GetMotionFactor - The smoothed amount of motion, from 0 (static) to 1 (fast motion / frequent scene changes)
+	*/
+	float GetMotionFactor() const { return mMotionFactor; }
+
+	/**
+	* GetBitsPerPixel - The bits per pixel matching the measured motion, ready to be passed to TTV_GetMaxResolution.
+	* Returns 0.1 (average motion) until two frames have been analyzed.
+	*/
+	float GetBitsPerPixel() const;
+
+	/**
+	* GetRecommendedResolution - Same as TTV_GetMaxResolution but uses the measured motion for the bits per pixel.
+	* @param[in] maxKbps - Maximum bitrate supported
+	* @param[in] frameRate - The desired frame rate
+	* @param[in] aspectRatio - The aspect ratio of the video
+	* @param[out] width - Maximum recommended width
+	* @param[out] height - Maximum recommended height
+	* @return - TTV_EC_SUCCESS if function succeeds; error code otherwise
+	*/
+	TTV_ErrorCode GetRecommendedResolution(uint maxKbps, uint frameRate, float aspectRatio, uint* width, uint* height) const;
+
+private:
+	std::vector<uint8_t> mLuma[2];
+	uint mLumaWidth;
+	uint mLumaHeight;
+	uint mCurrent;
+	uint mFramesAnalyzed;
+	float mMotionFactor;
+};
@@ -7,6 +7,8 @@
 #include "streaming.h"
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 bool gSdkInitialized = false;			// Whether or not TTV_Init has been called.
 StreamState gStreamState = SS_Uninitialized;	// The current state of streaming.
@@ -25,9 +27,28 @@ TTV_IngestServer gIngestServer;			// The ingest server to use.
 
 std::vector<unsigned char*> gFreeBufferList;	// The list of free buffers.  The app needs to allocate exactly 3.
 std::vector<unsigned char*> gCaptureBuffers;	// The list of all buffers.
+std::vector<unsigned char*> gRetiredBuffers;	// The buffers of a stopped stream, deleted once TTV_Stop completes.
+
+const unsigned int kShutdownStopTimeoutMs = 3000;	// How long ShutdownStreaming() waits for the stream to stop before shutting down the SDK anyway.
+bool gStopPending = false;						// Whether TTV_Stop has been called and not completed yet.
+bool gStartPending = false;						// Whether StartStreaming() was called while the stream was starting or stopping.
+bool gStartCancelled = false;					// Whether StopStreaming() was called while TTV_Start was in progress.
+
+const unsigned int kMaxCongestedSeconds = 10;	// How long to keep dropping frames on a backed up network before giving up.
+unsigned int gOutputWidth = 0;					// The broadcast width passed to StartStreaming().
+unsigned int gOutputHeight = 0;					// The broadcast height passed to StartStreaming().
+unsigned int gTargetFps = 0;					// The frame rate passed to StartStreaming().
+unsigned int gCongestedFrames = 0;				// The number of frames dropped in a row because the network is backed up.
+
+const unsigned int kMaxReconnectAttempts = 6;	// How many times to try restarting a broadcast that lost its connection.
+const unsigned int kFirstReconnectDelayMs = 250;	// The delay before the first attempt, doubled for each following attempt.
+const unsigned int kMaxReconnectDelayMs = 8000;	// The longest delay between two attempts.
+unsigned int gReconnectAttempts = 0;			// The number of attempts made since the connection was lost.
+std::chrono::steady_clock::time_point gReconnectTime;	// When to make the next attempt.
 
 // Forward declarations
 void ReportError(const char* format, ...);
+void ScheduleReconnect(TTV_ErrorCode err);
 
 
 #pragma region Callbacks
@@ -145,10 +166,99 @@ void FrameUnlockCallback(const uint8_t* buffer, void* /*userData*/)
 {
 	unsigned char* p = const_cast<unsigned char*>(buffer);
 
+	// Buffers of a stream that was stopped are deleted when the stop completes
+	if (std::find(gCaptureBuffers.begin(), gCaptureBuffers.end(), p) == gCaptureBuffers.end())
+	{
+		return;
+	}
+
 	// Put back on the free list
 	gFreeBufferList.push_back(p);
 }
 
+/**
+ * Callback from the SDK when the stream has stopped and no longer uses the capture buffers.
+ */
+void StopDoneCallback(TTV_ErrorCode result, void* /*userData*/)
+{
+	if ( TTV_FAILED(result) )
+	{
+		const char* err = TTV_ErrorToString(result);
+		ReportError("StopDoneCallback got failure: %s\n", err);
+	}
+
+	// Delete the capture buffers of the stopped stream
+	for (unsigned int i=0; i<gRetiredBuffers.size(); ++i)
+	{
+		delete [] gRetiredBuffers[i];
+	}
+	gRetiredBuffers.clear();
+
+	// A start requested while stopping is made by FlushStreamingEvents() rather than from within TTV_PollTasks
+	gStopPending = false;
+}
+
+/**
+ * Callback from the SDK when TTV_Start has completed.
+ */
+void StartDoneCallback(TTV_ErrorCode result, void* /*userData*/)
+{
+	// The SDK was shut down while starting
+	if (gStreamState != SS_Starting)
+	{
+		return;
+	}
+
+	// StopStreaming() was called while starting, stop right away and then honor a start requested since
+	if (gStartCancelled)
+	{
+		gStartCancelled = false;
+		bool startPending = gStartPending;
+
+		if ( TTV_SUCCEEDED(result) )
+		{
+			gStreamState = SS_Streaming;
+			StopStreaming();
+		}
+		else
+		{
+			gStreamState = SS_ReadyToStream;
+		}
+
+		gStartPending = startPending;
+		return;
+	}
+
+	if ( TTV_FAILED(result) )
+	{
+		// Keep trying if this was an attempt to reconnect
+		if (gReconnectAttempts > 0)
+		{
+			ScheduleReconnect(result);
+			return;
+		}
+
+		gStreamState = SS_ReadyToStream;
+
+		const char* err = TTV_ErrorToString(result);
+		ReportError("Error while starting to stream: %s\n", err);
+		return;
+	}
+
+	// Now streaming
+	gStreamState = SS_Streaming;
+	gCongestedFrames = 0;
+
+	// Allocate exactly 3 buffers to use as the capture destination while streaming.
+	// These buffers are passed to the SDK.
+	for (unsigned int i=0; i<3; ++i)
+	{
+		unsigned char* pBuffer = new unsigned char[gOutputWidth*gOutputHeight*4];
+		gCaptureBuffers.push_back(pBuffer);
+		gFreeBufferList.push_back(pBuffer);
+	}
+}
+
 #pragma endregion
 
 
@@ -226,6 +336,83 @@ void InitializeStreaming(const std::string& username, const std::string& passwor
 }
 
 
+/**
+ * Starts the broadcast asynchronously so connecting to the ingest server doesn't block the game.  StartDoneCallback()
+ * allocates the capture buffers once the broadcast is up.
+ */
+void BeginStreaming(unsigned int outputWidth, unsigned int outputHeight, unsigned int targetFps)
+{
+	// Setup the video parameters
+	TTV_VideoParams videoParams = {sizeof(TTV_VideoParams)}
+	videoParams.outputWidth = outputWidth;
+	videoParams.outputHeight = outputHeight;
+	videoParams.targetFps = targetFps;
+
+	// Compute the rest of the fields based on the given parameters
+	TTV_GetDefaultParams(&videoParams);
+	videoParams.pixelFormat = TTV_PF_BGRA;
+
+	// Setup the audio parameters
+	TTV_AudioParams audioParams;
+	audioParams.size = sizeof(TTV_AudioParams);
+	audioParams.audioEnabled = true;
+	audioParams.enableMicCapture = true;
+	audioParams.enablePlaybackCapture = true;
+	audioParams.enablePassthroughAudio = false;
+
+	gStreamState = SS_Starting;
+	gOutputWidth = outputWidth;
+	gOutputHeight = outputHeight;
+	gTargetFps = targetFps;
+
+	TTV_ErrorCode ret = TTV_Start(&videoParams, &audioParams, &gIngestServer, 0, StartDoneCallback, nullptr);
+	if ( TTV_FAILED(ret) )
+	{
+		StartDoneCallback(ret, nullptr);
+	}
+}
+
+
+/**
+ * Determines whether an error was caused by the connection to the ingest server, which a new connection may fix.
+ */
+bool IsConnectionError(TTV_ErrorCode err)
+{
+	return (err > TTV_EC_SOCKET_ERR && err < TTV_EC_SOCKET_END) || 
+		   err == TTV_EC_RTMP_TIMEOUT || 
+		   err == TTV_EC_RTMP_UNABLE_TO_SEND_DATA;
+}
+
+
+/**
+ * Schedules the next attempt to restart a broadcast that lost its connection, backing off exponentially.  Gives up
+ * after kMaxReconnectAttempts.
+ */
+void ScheduleReconnect(TTV_ErrorCode err)
+{
+	if (gReconnectAttempts >= kMaxReconnectAttempts)
+	{
+		// not streaming anymore
+		gReconnectAttempts = 0;
+		gStreamState = SS_Initialized;
+
+		const char* errString = TTV_ErrorToString(err);
+		ReportError("Unable to reconnect the stream: %s\n", errString);
+		return;
+	}
+
+	unsigned int delayMs = kFirstReconnectDelayMs << gReconnectAttempts;
+	if (delayMs > kMaxReconnectDelayMs)
+	{
+		delayMs = kMaxReconnectDelayMs;
+	}
+
+	++gReconnectAttempts;
+	gReconnectTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+	gStreamState = SS_Reconnecting;
+}
+
+
 /**
  * Once InitializeStreaming() has called all callback functions and IsReadyToStream() returns true then this function
  * can be called which will initiate streaming.  Once streaming begins, the app must call SubmitFrame() to submit frames
@@ -249,48 +436,31 @@ void StartStreaming(unsigned int outputWidth, unsigned int outputHeight, unsigne
 		case SS_Paused:
 			return;
 
-		// Ready to stream
+		// Start again once a start that was cancelled has completed
+		case SS_Starting:
+			if (!gStartCancelled)
+			{
+				return;
+			}
+			break;
+
+		// Ready to stream, or retry right away while waiting to reconnect
 		case SS_ReadyToStream:
+		case SS_Reconnecting:
 			break;
 	}
 
-	// Setup the video parameters
-	TTV_VideoParams videoParams = {sizeof(TTV_VideoParams)}
-	videoParams.outputWidth = outputWidth;
-	videoParams.outputHeight = outputHeight;
-	videoParams.targetFps = targetFps;
-
-	// Compute the rest of the fields based on the given parameters
-	TTV_GetDefaultParams(&videoParams);
-	videoParams.pixelFormat = TTV_PF_BGRA;
-
-	// Setup the audio parameters
-	TTV_AudioParams audioParams;
-	audioParams.size = sizeof(TTV_AudioParams);
-	audioParams.audioEnabled = true;
-	audioParams.enableMicCapture = true;
-	audioParams.enablePlaybackCapture = true;
-	audioParams.enablePassthroughAudio = false;
-
-	TTV_ErrorCode ret = TTV_Start(&videoParams, &audioParams, &gIngestServer, 0, nullptr, nullptr);
-	if ( TTV_FAILED(ret) )
+	// The previous stream is still starting or stopping, start once it's done
+	if (gStopPending || gStreamState == SS_Starting)
 	{
-		const char* err = TTV_ErrorToString(ret);
-		ReportError("Error while starting to stream: %s\n", err);
+		gOutputWidth = outputWidth;
+		gOutputHeight = outputHeight;
+		gTargetFps = targetFps;
+		gStartPending = true;
 		return;
 	}
 
-	// Now streaming
-	gStreamState = SS_Streaming;
-
-	// Allocate exactly 3 buffers to use as the capture destination while streaming.
-	// These buffers are passed to the SDK.
-	for (unsigned int i=0; i<3; ++i)
-	{
-		unsigned char* pBuffer = new unsigned char[outputWidth*outputHeight*4];
-		gCaptureBuffers.push_back(pBuffer);
-		gFreeBufferList.push_back(pBuffer);
-	}
+	BeginStreaming(outputWidth, outputHeight, targetFps);
 }
 
 
@@ -332,11 +502,35 @@ void SubmitFrame(unsigned char* pBgraFrame)
 	}
 
 	TTV_ErrorCode ret = TTV_SubmitVideoFrame(pBgraFrame, FrameUnlockCallback, 0);
-	if ( TTV_FAILED(ret) )
+	if (ret == TTV_EC_FRAME_QUEUE_TOO_LONG)
 	{
-		// not streaming anymore
-		gStreamState = SS_Initialized;
+		// The network is backed up and the frame was not queued.  Drop it so the queue can drain instead of
+		// ending the broadcast.  Viewers see a stutter and audio keeps going.  Only give up if it doesn't clear.
+		gFreeBufferList.push_back(pBgraFrame);
+
+		++gCongestedFrames;
+		if (gCongestedFrames < gTargetFps * kMaxCongestedSeconds)
+		{
+			return;
+		}
+	}
+	else if ( TTV_SUCCEEDED(ret) )
+	{
+		gCongestedFrames = 0;
+		gReconnectAttempts = 0;
+	}
+
+	if ( IsConnectionError(ret) )
+	{
+		// The connection dropped, restart the broadcast instead of ending it
 		StopStreaming();
+		ScheduleReconnect(ret);
+	}
+	else if ( TTV_FAILED(ret) )
+	{
+		// not streaming anymore, stop first so the buffers are retired and TTV_Stop is called
+		StopStreaming();
+		gStreamState = SS_Initialized;
 
 		const char* err = TTV_ErrorToString(ret);
 		ReportError("Error while submitting frame to stream: %s\n", err);
@@ -386,7 +580,7 @@ bool IsStreaming()
  */
 bool IsReadyToStream()
 {
-	return gStreamState == SS_ReadyToStream;
+	return gStreamState == SS_ReadyToStream && !gStopPending && !gStartPending;
 }
 
 
@@ -397,6 +591,13 @@ void FlushStreamingEvents()
 {
 	TTV_PollTasks();
 
+	// Start the stream that was requested while the previous one was starting or stopping
+	if (gStartPending && !gStopPending && gStreamState != SS_Starting)
+	{
+		gStartPending = false;
+		StartStreaming(gOutputWidth, gOutputHeight, gTargetFps);
+	}
+
 	switch (gStreamState)
 	{
 		// Kick off an authentication request
@@ -426,11 +627,21 @@ void FlushStreamingEvents()
 			TTV_GetStreamInfo(&gAuthToken, StreamInfoDoneCallback, nullptr, gUserName.c_str(), &gStreamInfo);
 			break;
 		}
+		// Try to restart a broadcast that lost its connection
+		case SS_Reconnecting:
+		{
+			if (!gStopPending && std::chrono::steady_clock::now() >= gReconnectTime)
+			{
+				BeginStreaming(gOutputWidth, gOutputHeight, gTargetFps);
+			}
+			break;
+		}
 		// No action required
 		case SS_FindingIngestServer:
 		case SS_Authenticating:
 		case SS_Initialized:
 		case SS_Uninitialized:		
+		case SS_Starting:
 		case SS_Streaming:
 		case SS_Paused:
 		{
@@ -449,6 +660,23 @@ void FlushStreamingEvents()
  */
 void StopStreaming()
 {
+	// Cancel a pending reconnect or start
+	gStartPending = false;
+	if (gStreamState == SS_Reconnecting)
+	{
+		gReconnectAttempts = 0;
+		gStreamState = SS_ReadyToStream;
+		return;
+	}
+
+	// TTV_Start is still in progress, StartDoneCallback() stops the stream once it completes
+	if (gStreamState == SS_Starting)
+	{
+		gReconnectAttempts = 0;
+		gStartCancelled = true;
+		return;
+	}
+
 	if (!IsStreaming())
 	{
 		return;
@@ -457,20 +685,21 @@ void StopStreaming()
 	// No longer streaming
 	gStreamState = SS_ReadyToStream;
 
-	TTV_ErrorCode ret = TTV_Stop(nullptr, nullptr);
+	// The SDK may still be using the capture buffers until the stop completes
+	gRetiredBuffers.insert(gRetiredBuffers.end(), gCaptureBuffers.begin(), gCaptureBuffers.end());
+	gFreeBufferList.clear();
+	gCaptureBuffers.clear();
+
+	// Stop asynchronously so a stalled network doesn't block the game while old data is flushed
+	gStopPending = true;
+	TTV_ErrorCode ret = TTV_Stop(StopDoneCallback, nullptr);
 	if ( TTV_FAILED(ret) )
 	{
 		const char* err = TTV_ErrorToString(ret);
 		ReportError("Error while stopping the stream: %s\n", err);
-	}
 
-	// Delete the capture buffers
-	for (unsigned int i=0; i<gCaptureBuffers.size(); ++i)
-	{
-		delete [] gCaptureBuffers[i];
+		StopDoneCallback(TTV_EC_SUCCESS, nullptr);
 	}
-	gFreeBufferList.clear();
-	gCaptureBuffers.clear();
 }
 
 
@@ -486,16 +715,39 @@ void ShutdownStreaming()
 
 	StopStreaming();
 
+	// Give the stream a bounded amount of time to finish starting and flush, then shut down anyway.  This only bounds
+	// the wait here, TTV_Shutdown() may still block on a stalled network while the stop is outstanding.
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kShutdownStopTimeoutMs);
+	while ((gStopPending || gStreamState == SS_Starting) && std::chrono::steady_clock::now() < deadline)
+	{
+		TTV_PollTasks();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
 	gSdkInitialized = false;
 	gStreamState = SS_Uninitialized;
 
 	TTV_ErrorCode ret = TTV_Shutdown();
+
+	gStopPending = false;
+	gStartCancelled = false;
+
 	if ( TTV_FAILED(ret) )
 	{
+		// The SDK may still hold the buffers of the stopped stream so they are leaked rather than deleted
+		gRetiredBuffers.clear();
+
 		const char* err = TTV_ErrorToString(ret);
 		ReportError("Error while shutting down the Twitch SDK: %s\n", err);
 		return;
 	}
+
+	// The SDK no longer holds any buffers once it has shut down
+	for (unsigned int i=0; i<gRetiredBuffers.size(); ++i)
+	{
+		delete [] gRetiredBuffers[i];
+	}
+	gRetiredBuffers.clear();
 }
 
 
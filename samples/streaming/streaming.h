@@ -21,7 +21,9 @@
 	STREAM_STATE(FoundIngestServer)\
 	STREAM_STATE(ReadyToStream)\
 	STREAM_STATE(Streaming)\
-	STREAM_STATE(Paused)
+	STREAM_STATE(Paused)\
+	STREAM_STATE(Reconnecting)\
+	STREAM_STATE(Starting)
 
 
 #undef STREAM_STATE
@@ -653,7 +653,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 				// Toggle streaming
 				case VK_F5:
 				{
-					if (IsStreaming())
+					// Also cancels a broadcast that is still starting or waiting to reconnect
+					StreamState state = GetStreamState();
+					if (IsStreaming() || state == SS_Starting || state == SS_Reconnecting)
 					{
 						gStreamingDesired = false;
 						StopStreaming();
@@ -675,7 +677,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 				// Toggle broadcast resolution
 				case VK_F1:
 				{
-					bool streaming = IsStreaming();
+					StreamState state = GetStreamState();
+					bool reconnecting = state == SS_Reconnecting;
+					bool streaming = IsStreaming() || state == SS_Starting;
 					if (streaming)
 					{
 						StopStreaming();
@@ -692,7 +696,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 						gBroadcastHeight = 368;
 					}
 
-					if (streaming)
+					// Restart at the new resolution, a lost connection is retried right away
+					if (streaming || reconnecting)
 					{
 						StartStreaming(gBroadcastWidth, gBroadcastHeight, gBroadcastFramesPerSecond);
 					}